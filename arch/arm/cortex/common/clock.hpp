@@ -0,0 +1,108 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARM_CORTEX_COMMON_CLOCK_HPP_INCLUDED
+#define ARM_CORTEX_COMMON_CLOCK_HPP_INCLUDED
+
+#include <arch/systick.hpp>
+#include <chrono>
+#include <ratio>
+#include <cstdint>
+
+namespace mptl {
+
+/**
+ * Monotonic high resolution clock, combining the 64bit tick count of
+ * a systick time base (e.g. systick_tickless<>) with the systick
+ * counter value.
+ *
+ * Resolution is one systick counter cycle (e.g. 1/21MHz for
+ * systick_clock::external<> at 168MHz). The 64bit cycle count does
+ * not overflow within the lifetime of the device.
+ *
+ * Satisfies the std::chrono TrivialClock requirements:
+ *
+ *     using clock = mptl::clock< Kernel::time_base >;
+ *     auto t0 = clock::now();
+ *     ...
+ *     auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+ *
+ * now() can be called from any context (also with interrupts
+ * disabled, or from isr having higher priority than the systick
+ * isr): the 64bit tick count is read consistently (see
+ * time_base_type::get_tick64()), and a pending tick is accounted
+ * (see now_cycles()).
+ *
+ * NOTE: An isr preempting the systick isr before it accounted the
+ * tick (at the very start of time_base_type::isr()) reads the
+ * reloaded counter with the previous tick count: now() lags by one
+ * tick in this case.
+ */
+template< typename time_base_type >
+struct clock
+{
+  using systick = typename time_base_type::systick;
+
+  using rep        = int64_t;
+  using period     = std::ratio< 1, systick::counter_freq >;
+  using duration   = std::chrono::duration< rep, period >;
+  using time_point = std::chrono::time_point< clock >;
+
+  static constexpr bool is_steady = true;
+
+  /**
+   * Number of systick counter cycles since startup.
+   *
+   * The tick count and the counter are read in a retry loop, until
+   * no systick isr occured in between. If the counter was reloaded
+   * but the systick isr did not yet run (pending flag set), the
+   * counter is read again and the pending tick is accounted.
+   */
+  static uint64_t now_cycles(void) {
+    uint64_t tick;
+    uint32_t counter;
+    uint64_t tick_check;
+    do {
+      tick = time_base_type::get_tick64();
+      counter = systick::get_counter();
+      tick_check = tick;
+      if(systick::get_pending_flag()) {
+        counter = systick::get_counter();
+        tick++;
+      }
+    } while(tick_check != time_base_type::get_tick64());
+
+    /* counter counts down from reload_value to 0 */
+    return tick * time_base_type::tick_cycles + (time_base_type::reload_value - counter);
+  }
+
+  static time_point now(void) noexcept {
+    return time_point(duration(static_cast<rep>(now_cycles())));
+  }
+
+  /** Nanoseconds since startup */
+  static uint64_t now_ns(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now().time_since_epoch()).count();
+  }
+};
+
+} // namespace mptl
+
+#endif // ARM_CORTEX_COMMON_CLOCK_HPP_INCLUDED
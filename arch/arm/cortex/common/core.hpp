@@ -45,9 +45,29 @@ struct core_base
 
   static void nop(unsigned value) { while(value--) nop(); }
 
+  static uint32_t get_primask(void) {
+    uint32_t value;
+    __asm volatile ("mrs %0, primask" : "=r" (value));
+    return value;
+  }
+
+  /** BASEPRI: mask all irq's with priority value >= BASEPRI (0: no masking) */
+  static uint32_t get_basepri(void) {
+    uint32_t value;
+    __asm volatile ("mrs %0, basepri" : "=r" (value));
+    return value;
+  }
+  static void set_basepri(uint32_t value) {
+    __asm volatile ("msr basepri, %0" : : "r" (value) : "memory");
+  }
+  /** set BASEPRI only if value raises the masking priority */
+  static void set_basepri_max(uint32_t value) {
+    __asm volatile ("msr basepri_max, %0" : : "r" (value) : "memory");
+  }
+
   /* Startup code.
    *
-   *   - Initialize data and bss section
+   *   - Initialize data and bss regions (linker region table, see crt.hpp)
    *   - Set early-config registers
    *   - Set system clock
    *
@@ -64,8 +84,8 @@ struct core_base
     typename... early_cfg_list
     >
   static void startup(void) {
-    crt::init_data_section();
-    crt::init_bss_section();
+    crt::init_data_regions();
+    crt::init_bss_regions();
 
     system_clock_type::init();
     reglist< early_cfg_list... >::reset_to();
@@ -0,0 +1,179 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARM_CORTEX_COMMON_CRITICAL_SECTION_HPP_INCLUDED
+#define ARM_CORTEX_COMMON_CRITICAL_SECTION_HPP_INCLUDED
+
+#include <arch/core.hpp>
+#include <arch/nvic.hpp>
+#include <typelist.hpp>
+#include <type_traits>
+#include <cstdint>
+
+namespace mptl {
+
+namespace mpl {
+
+  /**
+   * Provides the preemption priority (8bit group priority value) of
+   * irq_type, as declared by irq_priority<> in the resources list.
+   * Defaults to 0 (reset value, highest priority) if not declared.
+   */
+  template< typename resources, typename irq_type >
+  struct irq_group_priority
+  {
+    using priority_list = typename resources::template filter_type< irq_priority_base >;
+    using irq_priority_type = typename priority_list::template filter< filter_irqn< irq_type::irqn > >::filter_unique::unique_element::type;
+
+    template< typename T, bool declared = !std::is_void< T >::value >
+    struct value_of : std::integral_constant< uint8_t, 0 > { };
+
+    template< typename T >
+    struct value_of< T, true >
+    : std::integral_constant< uint8_t, (T::priority << (8 - T::preempt_bits)) & 0xff >
+    { };
+
+    static constexpr uint8_t value = value_of< irq_priority_type >::value;
+  };
+
+  /** Provides the minimum group priority value (highest priority) of all irq_types */
+  template< typename resources, typename... irq_types >
+  struct priority_ceiling;
+
+  template< typename resources, typename irq_type >
+  struct priority_ceiling< resources, irq_type >
+  : std::integral_constant< uint8_t, irq_group_priority< resources, irq_type >::value >
+  { };
+
+  template< typename resources, typename irq_type, typename... irq_types >
+  struct priority_ceiling< resources, irq_type, irq_types... >
+  : std::integral_constant< uint8_t,
+                            ( irq_group_priority< resources, irq_type >::value < priority_ceiling< resources, irq_types... >::value ?
+                              irq_group_priority< resources, irq_type >::value :
+                              priority_ceiling< resources, irq_types... >::value ) >
+  { };
+
+#ifdef OPENMPTL_SIMULATION
+  /** Simulated PRIMASK and BASEPRI registers (no effect on simulated irq's) */
+  template< typename = void >
+  struct critical_section_core
+  {
+    static uint32_t primask;
+    static uint32_t basepri;
+
+    static uint32_t get_primask(void)          { return primask; }
+    static void disable_irq(void)              { primask = 1; }
+    static void enable_irq(void)               { primask = 0; }
+    static uint32_t get_basepri(void)          { return basepri; }
+    static void set_basepri(uint32_t value)    { basepri = value & 0xff; }
+    static void set_basepri_max(uint32_t value) {
+      value &= 0xff;
+      if(value && (!basepri || (value < basepri)))
+        basepri = value;
+    }
+  };
+
+  template< typename T > uint32_t critical_section_core< T >::primask;
+  template< typename T > uint32_t critical_section_core< T >::basepri;
+#else
+  template< typename = void >
+  using critical_section_core = core;
+#endif
+
+} // namespace mpl
+
+
+/**
+ * RAII critical section, using the priority ceiling protocol.
+ *
+ * Masks (by raising BASEPRI) all irq's with a priority lower or
+ * equal than the highest priority of the given irq_types, as
+ * declared by irq_priority<> traits in the resources list. Irq's
+ * with higher priority are not affected, and keep their latency.
+ *
+ * If the ceiling is 0 (highest priority, which is the default for
+ * irq's without irq_priority<> trait), BASEPRI can not be used, and
+ * all irq's are disabled (PRIMASK, same as core::disable_irq()).
+ *
+ * Critical sections can be nested (BASEPRI is never lowered within
+ * a critical section, and restored on destruction).
+ *
+ * Example:
+ *
+ *     using resources = mptl::typelist<
+ *       mptl::irq_priority< mptl::irq::usart<2>, 2 >,
+ *       mptl::irq_priority< mptl::irq::dma1_stream5, 3 >,
+ *       ...
+ *       >;
+ *
+ *     using usart_lock = mptl::critical_section< resources, mptl::irq::usart<2>, mptl::irq::dma1_stream5 >;
+ *
+ *     void reset_fifo(void) {
+ *       usart_lock lock;   // BASEPRI = 0x20: irq's with priority 0, 1 are still served
+ *       ...
+ *     }
+ *
+ * Template arguments:
+ *
+ *   - resources: typelist<>, containing mptl::irq_priority<> traits
+ *        (other traits are ignored)
+ *   - irq_types: irq's accessing the shared data
+ */
+template< typename resources, typename... irq_types >
+class critical_section
+{
+  static_assert(sizeof...(irq_types) > 0, "critical_section<> needs at least one irq_type");
+
+  using core_type = mpl::critical_section_core<>;
+
+  uint32_t saved;
+
+public:
+
+  /** BASEPRI value (0: PRIMASK is used instead) */
+  static constexpr uint8_t ceiling = mpl::priority_ceiling< resources, irq_types... >::value;
+
+  static constexpr bool use_basepri = (ceiling != 0);
+
+  critical_section(void) {
+    if(use_basepri) {  /* evaluated at compile-time */
+      saved = core_type::get_basepri();
+      core_type::set_basepri_max(ceiling);
+    }
+    else {
+      saved = core_type::get_primask();
+      core_type::disable_irq();
+    }
+  }
+
+  ~critical_section(void) {
+    if(use_basepri)
+      core_type::set_basepri(saved);
+    else if(saved == 0)
+      core_type::enable_irq();
+  }
+
+  critical_section(critical_section const &) = delete;
+  critical_section & operator=(critical_section const &) = delete;
+};
+
+} // namespace mptl
+
+#endif // ARM_CORTEX_COMMON_CRITICAL_SECTION_HPP_INCLUDED
@@ -43,6 +43,11 @@ public:
     DWT::CTRL::set(1);     // enable counter
   }
 
+  /** enable cycle counter, without resetting it */
+  static void cycle_counter_start(void) {
+    DWT::CTRL::set(1);
+  }
+
   static DWT::CYCCNT::value_type cycle_counter_load(void) {
     return DWT::CYCCNT::load();
   }
@@ -51,6 +56,9 @@ public:
 
 /**
  * Cycle counter: Count processor clock cycles
+ *
+ * NOTE: the DWT cycle counter is shared (e.g. by profile_scope<>),
+ * and is neither reset nor disabled by this class.
  */
 class cycle_counter
 {
@@ -62,11 +70,7 @@ public:
 
   cycle_counter(void) : value(0) {
     dwt::enable();
-    dwt::cycle_counter_enable();
-  }
-
-  ~cycle_counter(void) {
-    dwt::disable();
+    dwt::cycle_counter_start();
   }
 
   void start(void) {
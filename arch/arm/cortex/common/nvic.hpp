@@ -43,20 +43,6 @@ struct irq_base {
 template<int irqn>
 class core_exception : public irq_base<irqn> {
   static_assert(irqn < 0 && irqn > -16, "illegal core exception interrupt number");
-
-#if 0
-public:
-
-  static constexpr bool priority_available = irqn > -13;
-
-  static typename std::enable_if<priority_available>::type set_priority(uint32_t priority) {
-    scb::set_priority<irqn>(priority);
-  }
-
-  static typename std::enable_if<priority_available, uint32_t>::type get_priority(void) {
-    return scb::set_priority<irqn>();
-  }
-#endif
 };
 
 
@@ -75,7 +61,6 @@ class irq_channel : public irq_base<irqn> {
   using ISPRx = NVIC::ISPR<reg_index>;
   using ICPRx = NVIC::ICPR<reg_index>;
   using IABRx = NVIC::IABR<reg_index>;
-  using IPRx  = NVIC::IPR<irqn>;
 
 public:
 
@@ -99,16 +84,6 @@ public:
   static bool is_active(void) {
     return IABRx::load() & (irq_bit);
   }
-
-#if 0
-  static void set_priority(uint32_t priority) {
-    IPRx::store((priority << (8 - priority_bits)) & 0xff);
-  }
-
-  static uint32_t get_priority(void) {
-    return((uint32_t)(IPRx::load() >> (8 - priority_bits)));
-  }
-#endif
 };
 
 
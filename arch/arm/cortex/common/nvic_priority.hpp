@@ -0,0 +1,157 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARM_CORTEX_COMMON_NVIC_PRIORITY_HPP_INCLUDED
+#define ARM_CORTEX_COMMON_NVIC_PRIORITY_HPP_INCLUDED
+
+/*
+ * NOTE: this file is included at the end of arch/nvic.hpp, and needs
+ * irq::priority_bits to be defined.
+ */
+
+#include "nvic.hpp"
+#include "reg/scb.hpp"
+#include <register.hpp>
+
+namespace mptl {
+
+namespace mpl {
+
+  /** Priority register and bit offset of irq channels (NVIC::IPR) */
+  template< int irqn, bool is_core_exception = (irqn < 0) >
+  struct irq_priority_reg {
+    using type = NVIC::IPR< irqn / 4 >;
+    static constexpr unsigned offset = (irqn % 4) * 8;
+  };
+
+  /** Priority register and bit offset of core exceptions (SCB::SHPR) */
+  template< int irqn >
+  struct irq_priority_reg< irqn, true > {
+    static_assert(irqn > irq::hard_fault::irqn, "priority of reset, nmi and hard_fault is fixed");
+    static_assert(!irq::reserved_irqn(irqn), "irq number is reserved");
+
+    static constexpr unsigned system_handler = irqn + 16;
+    using type = SCB::SHPR< (system_handler - 4) / 4 >;
+    static constexpr unsigned offset = (system_handler % 4) * 8;
+  };
+
+} // namespace mpl
+
+
+/** Tag for irq_priority<> traits (see below) */
+struct irq_priority_base { };
+
+
+/**
+ * Interrupt priority trait: Sets the NVIC::IPR (irq channels) or
+ * SCB::SHPR (core exceptions) priority field of an irq when
+ * passed to make_reglist<>::reset_to().
+ *
+ * Lower values have higher priority. An irq can only preempt an
+ * isr of higher (preemption) priority value; subpriority only
+ * decides the order of pending irq's.
+ *
+ * Conflicting declarations of the same irq are caught at
+ * compile-time by the regmask<> merge (static_assert "set/clear
+ * check failed").
+ *
+ * Example:
+ *
+ *     using resources = mptl::typelist<
+ *       mptl::irq_priority< mptl::irq::usart<2>, 1 >,
+ *       mptl::irq_priority< mptl::irq::adc,      2 >,
+ *       ...
+ *       >;
+ *     mptl::make_reglist< resources >::reset_to();
+ *
+ * Template arguments:
+ *
+ *   - irq_type: irq_channel<> or (settable) core_exception<>
+ *   - priority: preemption priority (0 .. 2^preempt_bits - 1)
+ *   - subpriority: subpriority (0 .. 2^(priority_bits - preempt_bits) - 1)
+ *   - preempt_bits: number of preemption priority bits, must match
+ *       the irq_priority_grouping<> (see below). Defaults to
+ *       irq::priority_bits (no subpriority, reset value of AIRCR).
+ */
+template<
+  typename _irq_type,
+  unsigned _priority,
+  unsigned _subpriority = 0,
+  unsigned _preempt_bits = irq::priority_bits
+  >
+class irq_priority
+: public irq_priority_base,
+  public regval<
+    regbits< typename mpl::irq_priority_reg< _irq_type::irqn >::type,
+             mpl::irq_priority_reg< _irq_type::irqn >::offset + 8 - irq::priority_bits,
+             irq::priority_bits >,
+    (_priority << (irq::priority_bits - _preempt_bits)) | _subpriority
+    >
+{
+  static_assert(_preempt_bits <= irq::priority_bits, "preempt_bits exceeds number of implemented priority bits");
+  static_assert(_priority < (1u << _preempt_bits), "preemption priority out of range");
+  static_assert(_subpriority < (1u << (irq::priority_bits - _preempt_bits)), "subpriority out of range");
+
+public:
+  using irq_type = _irq_type;
+  static constexpr unsigned priority     = _priority;
+  static constexpr unsigned subpriority  = _subpriority;
+  static constexpr unsigned preempt_bits = _preempt_bits;
+
+  /** priority field value (8bit, as in NVIC::IPR and SCB::SHPR) */
+  static constexpr uint8_t priority_value = ((_priority << (irq::priority_bits - _preempt_bits)) | _subpriority) << (8 - irq::priority_bits);
+};
+
+
+/**
+ * Priority grouping trait: Sets the SCB::AIRCR::PRIGROUP field
+ * (split of the priority bits into preemption priority and
+ * subpriority) when passed to make_reglist<>::reset_to().
+ *
+ * Example (2 bits preemption priority, 2 bits subpriority):
+ *
+ *     using prio_group = mptl::irq_priority_grouping< 2 >;
+ *     using resources = mptl::typelist<
+ *       prio_group,
+ *       prio_group::irq_priority< mptl::irq::usart<2>, 1, 0 >,
+ *       prio_group::irq_priority< mptl::irq::adc,      1, 3 >,
+ *       ...
+ *       >;
+ *
+ * NOTE: AIRCR is written with VECTKEY on reset_to(), all other bits
+ * are reset (SYSRESETREQ, VECTRESET and VECTCLRACTIVE are zero).
+ */
+template< unsigned preempt_bits >
+class irq_priority_grouping
+: public merged_regmask<
+    regval< SCB::AIRCR::VECTKEY, 0x5FA >,
+    regval< SCB::AIRCR::PRIGROUP, 7 - preempt_bits >
+    >
+{
+  static_assert(preempt_bits <= irq::priority_bits, "preempt_bits exceeds number of implemented priority bits");
+
+public:
+  template< typename irq_type, unsigned priority, unsigned subpriority = 0 >
+  using irq_priority = mptl::irq_priority< irq_type, priority, subpriority, preempt_bits >;
+};
+
+} // namespace mptl
+
+#endif // ARM_CORTEX_COMMON_NVIC_PRIORITY_HPP_INCLUDED
@@ -23,42 +23,4 @@
 
 #include "reg/scb.hpp"
 
-#if 0  // TODO: fixme
-
-namespace mptl {
-
-template<unsigned priority_bits>
-class scb
-{
-public:
-
-  static void set_priority_group(uint32_t group) {
-    // assert(group == (group & 0x07));
-
-    SCB::AIRCR::set<SCB::AIRCR::VECTKEY, SCB::AIRCR::PRIGROUP>
-      ( SCB::AIRCR::VECTKEY ::shifted_value(0x5FA) |
-        SCB::AIRCR::PRIGROUP::shifted_value(group) );
-  }
-
-  static uint32_t get_priority_group(void) {
-    return SCB::AIRCR::PRIGROUP::test_and_shift();
-  }
-
-  template<int irqn>
-  static void set_priority(uint32_t priority) {
-    static_assert(irqn < 0 && irqn > -13, "illegal core exception interrupt number");
-    SCB::SHPR<((uint32_t)irqn & 0xf)-4>::store((priority << (8 - priority_bits)) & 0xff);
-  }
-
-  template<int irqn>
-  static uint32_t get_priority(void) {
-    static_assert(irqn < 0 && irqn > -13, "illegal core exception interrupt number");
-    return((uint32_t)(SCB::SHPR<((uint32_t)irqn & 0xf)-4>::load() >> (8 - priority_bits)));
-  }
-};
-
-} // namespace mptl
-
-#endif
-
 #endif // ARM_CORTEX_COMMON_SCB_HPP_INCLUDED
@@ -22,8 +22,10 @@
 #define ARM_CORTEX_COMMON_SYSTICK_HPP_INCLUDED
 
 #include <arch/nvic.hpp>
+#include <arch/core.hpp>
 #include <typelist.hpp>
 #include <freq.hpp>
+#include <atomic>
 
 
 namespace mptl {
@@ -104,6 +106,10 @@ public:
   static bool get_count_flag(void) {
     return SCB::STCSR::COUNTFLAG::test();
   }
+  /** true if the systick exception is pending (counter reloaded, isr not yet executed) */
+  static bool get_pending_flag(void) {
+    return SCB::ICSR::PENDSTSET::test();
+  }
   static bool get_skew_flag(void) {
     return SCB::STCR::SKEW::test();
   }
@@ -117,6 +123,203 @@ public:
   }
 };
 
+
+/**
+ * Tickless time base on top of systick<>.
+ *
+ * Counts systick interrupts (ticks of systick_type::freq), but
+ * allows the core to sleep for several ticks: sleep() reprograms the
+ * systick reload register to fire at the requested wakeup tick, and
+ * compensates the tick count from the counter value when the core is
+ * woken up early by another interrupt. The tick count as returned by
+ * get_tick() stays monotonic and coherent (ISRs woken up from sleep
+ * are executed after the compensation).
+ *
+ * Usage:
+ *
+ *   - register isr() as systick irq handler
+ *   - call sleep() instead of core::wfi() in the idle loop (see
+ *     scheduler::run<tickless_type>())
+ *
+ * NOTE: systick keeps running in sleep mode only. Deep sleep (stop
+ * mode) requires a different wakeup source (e.g. rtc alarm).
+ */
+template< typename systick_type >
+class systick_tickless
+{
+  /* 64bit tick count, double buffered: add_ticks() writes the
+   * inactive copy and publishes it by incrementing tick_seq. A
+   * reader preempting add_ticks() gets the previous (consistent)
+   * copy, and never has to wait for the writer. */
+  struct tick64_copy {
+    std::atomic<unsigned> low;
+    std::atomic<unsigned> high;
+  };
+
+  static std::atomic<unsigned> tick_count;  /**< lower 32 bits of tick count */
+  static std::atomic<unsigned> tick_seq;
+  static tick64_copy tick64[2];
+
+  /* NOTE: called from isr() or with interrupts disabled (single writer) */
+  static void add_ticks(unsigned n) {
+    unsigned seq = tick_seq.load(std::memory_order_relaxed);
+    tick64_copy & prev = tick64[seq & 1];
+    tick64_copy & next = tick64[(seq + 1) & 1];
+    unsigned low  = prev.low.load(std::memory_order_relaxed);
+    unsigned high = prev.high.load(std::memory_order_relaxed);
+    if(low + n < low)
+      high++;
+    next.low.store(low + n, std::memory_order_relaxed);
+    next.high.store(high, std::memory_order_relaxed);
+    tick_seq.store(seq + 1, std::memory_order_release);
+    tick_count.store(low + n, std::memory_order_release);
+  }
+
+  static void restart(SCB::STRVR::value_type counter) {
+    /* counter is loaded from STRVR on the first systick clock edge
+     * after enabling, the new reload value takes effect at the next
+     * tick. Zero would stop the counter. */
+    if(counter == 0)
+      counter = 1;
+    systick_type::set_reload(counter);
+    systick_type::clear_counter();
+    systick_type::enable_counter();
+#ifndef OPENMPTL_SIMULATION
+    /* Wait for the counter to be loaded before restoring STRVR:
+     * with external clock (HCLK/8), the next systick clock edge
+     * can be several core cycles away. Restoring STRVR too early
+     * turns the partial tick into a full tick (drift on every
+     * wakeup). */
+    while(systick_type::get_counter() == 0) { }
+#endif
+    systick_type::set_reload(reload_value);
+  }
+
+public:
+
+  using systick = systick_type;
+
+  /** STRVR value for a single tick (as set by systick_type::resources) */
+  static constexpr uint32_t reload_value = systick_type::reload_value;
+
+  /** counter cycles per tick (the counter counts from STRVR down to 0) */
+  static constexpr uint32_t tick_cycles = reload_value + 1;
+
+  /** maximum number of ticks sleep() can suspend (24bit counter) */
+  static constexpr unsigned max_sleep_ticks = (0xffffff - reload_value) / tick_cycles + 1;
+
+  static_assert(reload_value <= 0xffffff, "systick reload value exceeds 24bit counter");
+
+  static void isr(void) {
+    add_ticks(1);
+  }
+
+  static unsigned get_tick(void) {
+    return tick_count.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * 64bit tick count (never wraps).
+   *
+   * Consistent from any context: retries if the systick isr updated
+   * the tick count in between, and returns the previous value when
+   * called from an isr preempting the update.
+   */
+  static uint64_t get_tick64(void) {
+    unsigned seq, high, low;
+    do {
+      seq = tick_seq.load(std::memory_order_acquire);
+      low  = tick64[seq & 1].low.load(std::memory_order_acquire);
+      high = tick64[seq & 1].high.load(std::memory_order_acquire);
+    } while(seq != tick_seq.load(std::memory_order_acquire));
+    return ((uint64_t)high << 32) | low;
+  }
+
+#ifdef OPENMPTL_SIMULATION
+  /** Set the 64bit tick count (e.g. close to a wrap of the lower 32 bits) */
+  static void sim_set_tick64(uint64_t tick) {
+    unsigned seq = tick_seq.load(std::memory_order_relaxed);
+    tick64[seq & 1].low.store(static_cast<unsigned>(tick), std::memory_order_relaxed);
+    tick64[seq & 1].high.store(static_cast<unsigned>(tick >> 32), std::memory_order_relaxed);
+    tick_count.store(static_cast<unsigned>(tick), std::memory_order_relaxed);
+  }
+#endif
+
+  /**
+   * Sleep (wfi) for at most ticks systick periods, or until an
+   * interrupt occurs.
+   *
+   * NOTE: must be called with interrupts disabled (see
+   * core::disable_irq()), pending interrupts are executed after
+   * interrupts are enabled again.
+   */
+  static void sleep(unsigned ticks) {
+    if(ticks > max_sleep_ticks)
+      ticks = max_sleep_ticks;
+
+    if(ticks < 2) {
+      core::wfi();
+      return;
+    }
+
+    systick_type::disable_counter();
+
+    if(systick_type::get_pending_flag()) {
+      /* tick elapsed just before disabling the counter, don't sleep */
+      systick_type::enable_counter();
+      return;
+    }
+
+    /* remaining cycles of the current tick, plus (ticks - 1) full ticks */
+    uint32_t current = systick_type::get_counter();
+    uint32_t reload  = current + tick_cycles * (ticks - 1);
+
+    systick_type::set_reload(reload);
+    systick_type::clear_counter();
+    systick_type::enable_counter();
+
+    core::dsb();
+    core::wfi();
+    core::isb();
+
+    /* Disable the counter before checking for expiry: otherwise the
+     * counter could expire in between, and the reloaded counter
+     * would be taken for the remaining cycles of an early wakeup.
+     * NOTE: COUNTFLAG is cleared by the STCSR read in
+     * disable_counter(), check the pending flag instead (set on
+     * expiry, as TICKINT is enabled for isr()). */
+    systick_type::disable_counter();
+    bool expired = systick_type::get_pending_flag();
+    uint32_t counter = systick_type::get_counter();
+    unsigned elapsed;
+
+    if(expired) {
+      /* The systick irq is pending, and accounts for the last tick.
+       * The counter was reloaded with "reload" value on expiry. */
+      uint32_t overrun = reload - counter;
+      elapsed = ticks - 1;
+      restart(overrun < reload_value ? reload_value - overrun : reload_value);
+    }
+    else {
+      /* woken up by another interrupt: count complete ticks, and
+       * restart the counter with the remaining cycles of the
+       * current tick */
+      uint32_t cycles = (reload_value - current) + (reload - counter);
+      elapsed = cycles / tick_cycles;
+      restart(reload_value - (cycles % tick_cycles));
+    }
+
+    add_ticks(elapsed);
+  }
+};
+
+template< typename systick_type >
+std::atomic<unsigned> systick_tickless< systick_type >::tick_count;
+template< typename systick_type >
+std::atomic<unsigned> systick_tickless< systick_type >::tick_seq;
+template< typename systick_type >
+typename systick_tickless< systick_type >::tick64_copy systick_tickless< systick_type >::tick64[2];
+
 } // namespace mptl
 
 #endif // ARM_CORTEX_COMMON_SYSTICK_HPP_INCLUDED
@@ -22,6 +22,7 @@
 #define ARM_CORTEX_COMMON_VECTOR_TABLE_HPP_INCLUDED
 
 #include <arch/nvic.hpp>
+#include <arch/core.hpp>
 #include <typelist.hpp>
 #include <simulation.hpp>
 #include <type_traits>
@@ -42,9 +43,26 @@ struct arm_cortex_vector_table {
   isr_t isr_vector[vt_size];
 };
 
+/** Vector table in RAM (writable isr_vector, aligned for SCB::VTOR) */
+template<std::size_t vt_size, std::size_t alignment>
+struct alignas(alignment) arm_cortex_ram_vector_table {
+  using isr_type = void (*)(void);
+
+  const uint32_t * stack_top;
+  isr_type isr_vector[vt_size];
+};
+
 
 namespace mpl
 {
+  /**
+   * Alignment of a vector table of given size (in bytes) for
+   * SCB::VTOR: next power of two, at least 128 bytes.
+   */
+  static inline constexpr std::size_t vtor_alignment(std::size_t size, std::size_t alignment = 128) {
+    return alignment >= size ? alignment : vtor_alignment(size, alignment * 2);
+  }
+
   /**
    * Provides a arm_cortex_vector_table in static member "value" which
    * can be used to fill linker section ".isr_vector", containing
@@ -61,6 +79,16 @@ namespace mpl
     static constexpr std::size_t size = vt_size + 1;
     static constexpr arm_cortex_vector_table<vt_size> value = { stack_top, { Tp::value... } };
 
+    static constexpr std::size_t ram_alignment = vtor_alignment(sizeof(arm_cortex_vector_table<vt_size>));
+    using ram_table_type = arm_cortex_ram_vector_table<vt_size, ram_alignment>;
+
+    /**
+     * Copy of "value" in RAM (section ".data", initialized from flash
+     * by crt::init_data_regions()). Only allocated if used, see
+     * vector_table::relocate().
+     */
+    static ram_table_type ram_value;
+
 #ifdef OPENMPTL_SIMULATION
     /** Dump demangled irq_handler types to std::cout */
     static void dump_types(void) {
@@ -85,6 +113,12 @@ namespace mpl
 #endif
   };
 
+  template<const uint32_t *stack_top, typename... Tp>
+  typename vector_table_impl<stack_top, Tp...>::ram_table_type vector_table_impl<stack_top, Tp...>::ram_value = {
+    stack_top,
+    { Tp::value... }
+  };
+
 #if 0
   /* see comment above */
   template<const uint32_t *stack_top, typename... Tp>
@@ -94,11 +128,46 @@ namespace mpl
   };
 #endif
 
+  template< bool enabled, typename isr_wrapper, typename irq_handler_type >
+  struct wrap_irq_handler_impl {
+    using type = irq_handler_type;
+  };
+
+  template< typename isr_wrapper, typename irq_handler_type >
+  struct wrap_irq_handler_impl< true, isr_wrapper, irq_handler_type > {
+    using irq_type = typename irq_handler_type::irq_type;
+    using type = irq_handler< irq_type, &isr_wrapper::template wrap< irq_handler_type >::isr >;
+  };
+
+  /**
+   * Provides irq_handler<> with isr replaced by
+   * isr_wrapper::wrap<irq_handler_type>::isr.
+   *
+   * Not wrapped if isr_wrapper is void, for the reset handler (runs
+   * before the data sections are initialized, and never returns), and
+   * for empty handlers (nullptr).
+   */
+  template< typename isr_wrapper, typename irq_handler_type >
+  struct wrap_irq_handler
+  : wrap_irq_handler_impl<
+    ( !std::is_void< isr_wrapper >::value &&
+      (irq_handler_type::irq_type::irqn != irq::reset::irqn) &&
+      (irq_handler_type::value != nullptr) ),
+    isr_wrapper,
+    irq_handler_type >
+  { };
+
+  template< typename isr_wrapper >
+  struct wrap_irq_handler< isr_wrapper, void > {
+    using type = void;
+  };
+
   /** recursively build the vector table  */
   template< unsigned int N,
             int          irqn_offset,
             typename     irq_handler_list,
             isr_t        default_isr,
+            typename     isr_wrapper,
             const        uint32_t *stack_top,
             typename...  Tp >
   struct make_vector_table
@@ -114,7 +183,7 @@ namespace mpl
       ( irq::reserved_irqn(irqn) ||
         std::is_void< irq_handler_resource >::value ),
       irq_handler_default,
-      irq_handler_resource >::type;
+      typename wrap_irq_handler< isr_wrapper, irq_handler_resource >::type >::type;
 
     /** recursion */
     using type = typename make_vector_table<
@@ -122,6 +191,7 @@ namespace mpl
       irqn_offset,
       irq_handler_list,
       default_isr,
+      isr_wrapper,
       stack_top,
       irq_handler_type,
       Tp...
@@ -132,9 +202,10 @@ namespace mpl
   template< int              irqn_offset,
             typename         irq_handler_list,
             isr_t            default_isr,
+            typename         isr_wrapper,
             const uint32_t * stack_top,
             typename...      Tp >
-  struct make_vector_table< 0, irqn_offset, irq_handler_list, default_isr, stack_top, Tp... > {
+  struct make_vector_table< 0, irqn_offset, irq_handler_list, default_isr, isr_wrapper, stack_top, Tp... > {
     using type = vector_table_impl<stack_top, Tp...>;
   };
 } // namespace mpl
@@ -154,6 +225,14 @@ namespace mpl
  *     using vector_table = mptl::vector_table<&_stack_top, resources>;
  *     const auto isr_vector __attribute__((used, section(".isr_vector"))) = vector_table::value;
  *
+ * Optionally, the vector table can be relocated to RAM (after the
+ * data section is initialized), allowing to swap isr's at runtime:
+ *
+ *     vector_table::relocate();
+ *     vector_table::set_handler< mptl::irq::dma2_stream0 >(my_fast_isr);
+ *     ...
+ *     vector_table::restore_handler< mptl::irq::dma2_stream0 >();
+ *
  * Template arguments:
  *
  *   - stack_top: pointer to reset value of stack pointer
@@ -164,18 +243,24 @@ namespace mpl
  *   - default_isr: isr_t function pointer, used for all irq's which
  *        are not listed in irq_handler_list. Defaults to "nullptr".
  *
+ *   - isr_wrapper: if not void, all isr's from irq_handler_list are
+ *        replaced by "isr_wrapper::wrap<irq_handler_type>::isr"
+ *        (e.g. mptl::isr_trace<>, see lib/include/isr_trace.hpp).
+ *        Defaults to "void" (no wrapping).
+ *
  */
-template<const uint32_t *stack_top, typename irq_handler_list, isr_t default_isr = nullptr >
+template<const uint32_t *stack_top, typename irq_handler_list, isr_t default_isr = nullptr, typename isr_wrapper = void >
 struct vector_table
 : mpl::make_vector_table<
   irq::numof_interrupt_channels - irq::reset::irqn,  /* start index */
   irq::reset::irqn,  /* irqn_offset (negative) */
   irq_handler_list,
   default_isr,
+  isr_wrapper,
   stack_top
   >::type
 {
-  using type = vector_table<stack_top, irq_handler_list, default_isr>;
+  using type = vector_table<stack_top, irq_handler_list, default_isr, isr_wrapper>;
 
   /** offset of irq_channel<0> in arm_cortex_vector_table::isr_vector[] */
   static constexpr int irq_channel_offset = -irq::reset::irqn;
@@ -186,6 +271,57 @@ struct vector_table
   static_assert(sizeof(type::value) == sizeof(isr_t) * (1 + irq::numof_interrupt_channels + numof_core_exceptions),
                 "IRQ vector table size error");
 
+private:
+
+  template<typename irq_type>
+  static constexpr int isr_vector_index(void) {
+    static_assert(std::is_base_of< irq_base< irq_type::irqn >, irq_type >::value, "irq_type is not an irq (derived from mptl::irq_base<>)");
+    static_assert((irq_type::irqn > irq::reset::irqn) && (irq_type::irqn < irq::numof_interrupt_channels), "irq number out of range");
+    static_assert(!irq::reserved_irqn(irq_type::irqn), "irq number is reserved");
+    return irq_channel_offset + irq_type::irqn;
+  }
+
+public:
+
+  /**
+   * Set SCB::VTOR to the RAM copy of the vector table (ram_value).
+   *
+   * NOTE: ram_value is located in the data section, call this after
+   * crt::init_data_regions() (e.g. after core::startup()).
+   */
+  static void relocate(void) {
+    SCB::VTOR::store(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&type::ram_value)));
+#ifndef OPENMPTL_SIMULATION
+    core::dsb();
+    core::isb();
+#endif
+  }
+
+  /**
+   * Set isr in RAM vector table.
+   *
+   * Only effective after relocate(). Note that the isr is not wrapped
+   * by isr_wrapper (if any).
+   */
+  template<typename irq_type>
+  static void set_handler(isr_t isr) {
+    /* single word write: an exception fetches either the old or the new isr */
+    type::ram_value.isr_vector[isr_vector_index<irq_type>()] = isr;
+  }
+
+  /** Get isr from RAM vector table */
+  template<typename irq_type>
+  static typename type::ram_table_type::isr_type get_handler(void) {
+    return type::ram_value.isr_vector[isr_vector_index<irq_type>()];
+  }
+
+  /** Restore isr in RAM vector table from (compile-time) value */
+  template<typename irq_type>
+  static void restore_handler(void) {
+    constexpr isr_t isr = type::value.isr_vector[isr_vector_index<irq_type>()];
+    type::ram_value.isr_vector[isr_vector_index<irq_type>()] = isr;
+  }
+
 #ifdef OPENMPTL_SIMULATION
   static void dump_size(void) {
     int w = 3;
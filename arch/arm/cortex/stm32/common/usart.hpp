@@ -224,6 +224,14 @@ public:  /* ------ static member functions ------ */
 
   static void enable_tx_interrupt(void)  { USARTx::CR1::TXEIE::set(); }
   static void disable_tx_interrupt(void) { USARTx::CR1::TXEIE::clear(); }
+
+  /** Address of the data register (peripheral address for DMA transfers) */
+  static constexpr reg_addr_t data_register_addr = USARTx::DR::addr;
+
+  static void enable_dma_tx(void)  { USARTx::CR3::DMAT::set(); }
+  static void disable_dma_tx(void) { USARTx::CR3::DMAT::clear(); }
+  static void enable_dma_rx(void)  { USARTx::CR3::DMAR::set(); }
+  static void disable_dma_rx(void) { USARTx::CR3::DMAR::clear(); }
 };
 
 } // namespace mptl
@@ -22,29 +22,51 @@
 #define ARM_CORTEX_STM32_COMMON_USART_STREAM_HPP_INCLUDED
 
 #include <arch/usart.hpp>
+#include <arch/dma.hpp>
+#include <arch/critical_section.hpp>
 #include <fifo.hpp>
+#include <atomic>
 
 namespace mptl {
 
+/**
+ * Interrupt driven USART stream.
+ *
+ * Flow control:
+ *
+ *   - Use a flow_controlled_fifo<> as rx_fifo_type in order to
+ *     deassert RTS (gpio) on rx fifo high watermark, and assert it
+ *     again on low watermark.
+ *
+ *   - Configure the USART with usart_type::flow_control::cts in
+ *     order to pause transmission while CTS is deasserted. This is
+ *     done in hardware: no TXE interrupt occurs until the remote
+ *     side asserts CTS again.
+ */
 template<
   typename usart_type,
   typename _fifo_type, // = ring_buffer<char, 256>,
   bool     _crlf      = true,
-  bool     debug_irqs = false
+  bool     debug_irqs = false,
+  typename _rx_fifo_type = _fifo_type
   >
 class usart_irq_stream
 {
 public:
   static constexpr bool crlf = _crlf;
   using fifo_type = _fifo_type;
+  using rx_fifo_type = _rx_fifo_type;
   using char_type = char;
 
-  static fifo_type rx_fifo;
+  static rx_fifo_type rx_fifo;
   static fifo_type tx_fifo;
 
   static volatile unsigned int irq_count;
   static volatile unsigned int irq_errors;
 
+  /** number of received bytes lost due to rx_fifo overrun */
+  static volatile unsigned int rx_overrun;
+
 private:
 
   using SR = typename usart_type::USARTx::SR;
@@ -60,7 +82,8 @@ private:
 
     if(flags & SR::RXNE::value) {
       uint32_t data = usart_type::receive(); /* implicitely clears RXNE flag */
-      rx_fifo.push(data);
+      if(!rx_fifo.push(data))
+        rx_overrun++;
     }
     if(flags & SR::TXE::value) {
       char c;
@@ -101,6 +124,7 @@ public:
   static void open(void) {
     tx_fifo.reset();
     rx_fifo.reset();
+    rx_overrun = 0;
 
     usart_type::enable();
     usart_type::irq::enable();
@@ -121,18 +145,352 @@ public:
   }
 };
 
-template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs>
-fifo_type usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs>::rx_fifo;
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, typename rx_fifo_type>
+rx_fifo_type usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs, rx_fifo_type>::rx_fifo;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, typename rx_fifo_type>
+fifo_type usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs, rx_fifo_type>::tx_fifo;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, typename rx_fifo_type>
+volatile unsigned int usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs, rx_fifo_type>::irq_count;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, typename rx_fifo_type>
+volatile unsigned int usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs, rx_fifo_type>::irq_errors;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, typename rx_fifo_type>
+volatile unsigned int usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs, rx_fifo_type>::rx_overrun;
+
+
+/**
+ * USART stream using DMA for transmission.
+ *
+ * Same interface as usart_irq_stream<>, but instead of taking one TXE
+ * interrupt per byte, the largest contiguous block of tx_fifo
+ * (ring_buffer::read_region()) is handed to the DMA controller. The
+ * next block is started from the DMA transfer complete interrupt,
+ * until tx_fifo is empty.
+ *
+ * Reception is either interrupt driven (RXNE, one interrupt per
+ * byte), as in usart_irq_stream<>, or (if rx_dma is set) performed by
+ * a circular DMA transfer writing directly into the rx_fifo buffer
+ * storage. In the latter case, the rx_fifo write index is advanced on
+ * IDLE line detection, as well as on DMA half transfer and transfer
+ * complete interrupts: the CPU wakes up once per burst (or once per
+ * half rx_fifo) instead of once per byte.
+ *
+ * NOTE: fifo_type must provide read_region() and consume() (e.g.
+ * ring_buffer<char, N>), and rx_fifo_type must provide data() and
+ * commit_write_index() if rx_dma is set.
+ *
+ * NOTE: If rx_dma is set, the usart and DMA rx irqs must have the
+ * preemption priority (they must not preempt each other). Check
+ * this against the irq_priority<> traits of your application
+ * resources:
+ *
+ *     static_assert(usart_stream::rx_irq_priority_valid< resources >::value,
+ *                   "usart and DMA rx irqs must have the same priority");
+ *
+ * NOTE: If rx_dma is set, the DMA keeps writing into rx_fifo while
+ * it is full: on overrun, the most recent (size - 1) bytes are kept,
+ * and lost bytes are counted in rx_overrun. Bytes read by the
+ * consumer right before might be torn, which is reported by
+ * rx_fifo.test_and_clear_overrun() (see
+ * ring_buffer::commit_write_index()).
+ */
+template<
+  typename usart_type,
+  typename _fifo_type, // = ring_buffer<char, 256>,
+  bool     _crlf      = true,
+  bool     debug_irqs = false,
+  bool     rx_dma     = false,
+  typename _rx_fifo_type = _fifo_type
+  >
+class usart_dma_stream
+{
+public:
+  static constexpr bool crlf = _crlf;
+  using fifo_type = _fifo_type;
+  using rx_fifo_type = _rx_fifo_type;
+  using char_type = char;
+
+  using dma_tx = typename usart_dma< usart_type::usart_no >::tx;
+  using dma_rx = typename usart_dma< usart_type::usart_no >::rx;
+
+  static rx_fifo_type rx_fifo;
+  static fifo_type tx_fifo;
+
+  static volatile unsigned int irq_count;
+  static volatile unsigned int irq_errors;
+
+  /** number of received bytes lost due to rx_fifo overrun */
+  static volatile unsigned int rx_overrun;
+
+private:
+
+  using SR = typename usart_type::USARTx::SR;
+
+  /* number of bytes of the running DMA transfer */
+  static unsigned int tx_dma_count;
+
+  /* true while a DMA transfer is running (or being set up) */
+  static std::atomic<bool> tx_busy;
+
+  /* DMA write position in rx_fifo storage on last rx_dma_update() */
+  static unsigned int rx_dma_index;
+
+  /**
+   * Start DMA transfer of the next contiguous block in tx_fifo.
+   * Returns false if tx_fifo is empty.
+   *
+   * NOTE: called either with tx_busy acquired (flush()), or from the
+   * DMA transfer complete interrupt.
+   */
+  static bool start_tx(void) {
+    char * data;
+    unsigned int count = tx_fifo.read_region(data);
+    if(count == 0)
+      return false;
+
+    tx_dma_count = count;
+    dma_tx::set_memory_address(data);
+    dma_tx::set_count(count);
+    dma_tx::enable();
+    return true;
+  }
+
+  /* true if the DMA passed index pos when writing count bytes since last update */
+  static bool rx_dma_passed(unsigned int pos, unsigned int count) {
+    constexpr unsigned int size = rx_fifo_type::buffer_size;
+    return ((pos + size - rx_dma_index - 1) % size) + 1 <= count;
+  }
+
+  /**
+   * Publish the data written by the circular rx DMA transfer, up to
+   * the current DMA write position.
+   *
+   * The DMA position alone does not tell if the DMA completed a full
+   * lap since last update: a half transfer (HT) or transfer complete
+   * (TC) flag raised without passing the half (resp. end) of the
+   * rx_fifo storage adds a lap. More than one lap between two updates
+   * is not detected, which cannot happen unless the irqs are blocked
+   * for longer than it takes to receive rx_fifo_type::buffer_size
+   * bytes.
+   */
+  static void rx_dma_update(void) {
+    constexpr unsigned int size = rx_fifo_type::buffer_size;
+    bool ht = false;
+    bool tc = false;
+    unsigned int index;
+
+    /* Sample the DMA position after clearing the flags, and retry if
+     * a flag was raised in the meantime: every HT/TC event up to the
+     * sampled position is accounted in ht/tc, none after it. */
+    do {
+      ht |= dma_rx::half_transfer();
+      tc |= dma_rx::transfer_complete();
+      dma_rx::clear_flags();
+      index = size - dma_rx::get_count();
+    } while(dma_rx::half_transfer() || dma_rx::transfer_complete());
+    if(index >= size)
+      index = 0;
+
+    /* bytes written by the DMA since last update */
+    unsigned int count = (index >= rx_dma_index) ? (index - rx_dma_index) : (index + size - rx_dma_index);
+    if((ht && !rx_dma_passed(size - size / 2, count)) ||
+       (tc && !rx_dma_passed(0, count)))
+      count += size;
+    rx_dma_index = index;
+
+    rx_overrun += rx_fifo.commit_write_index(index, count);
+  }
+
+  static void isr(void) {
+    auto flags = SR::load();
+
+    if(debug_irqs) {
+      irq_count++;
+      if(flags & (SR::ORE::value | SR::FE::value | SR::NE::value | SR::PE::value))
+        irq_errors++;
+    }
+
+    if(rx_dma) {
+      if(flags & SR::IDLE::value) {
+        usart_type::receive(); /* SR read followed by DR read clears IDLE flag */
+        rx_dma_update();
+      }
+    }
+    else if(flags & SR::RXNE::value) {
+      uint32_t data = usart_type::receive(); /* implicitely clears RXNE flag */
+      if(!rx_fifo.push(data))
+        rx_overrun++;
+    }
+  }
+
+  static void dma_rx_isr(void) {
+    if(debug_irqs) {
+      irq_count++;
+      if(dma_rx::transfer_error())
+        irq_errors++;
+    }
+
+    rx_dma_update();  /* clears the flags */
+  }
+
+  static void dma_tx_isr(void) {
+    if(debug_irqs) {
+      irq_count++;
+      if(dma_tx::transfer_error())
+        irq_errors++;
+    }
+
+    dma_tx::clear_flags();
+    dma_tx::disable();
+
+    tx_fifo.consume(tx_dma_count);
+    tx_dma_count = 0;
+
+    if(!start_tx())
+      tx_busy.store(false);
+  }
+
+public:
+
+  using irq_resources = typelist<
+    irq_handler< typename usart_type::irq, isr >,
+    irq_handler< typename dma_tx::irq, dma_tx_isr >,
+    typename std::conditional< rx_dma, irq_handler< typename dma_rx::irq, dma_rx_isr >, void >::type
+    >;
+
+  using resources = typelist<
+    typename usart_type::resources,
+    typename dma_tx::resources,
+    typename std::conditional< rx_dma, typename dma_rx::resources, void >::type,
+    irq_resources
+    >;
+
+  /**
+   * True if the usart and DMA rx irqs have the same preemption
+   * priority in app_resources (see mpl::irq_group_priority), or if
+   * rx_dma is not set.
+   */
+  template< typename app_resources >
+  using rx_irq_priority_valid = std::integral_constant< bool,
+    !rx_dma ||
+    (mpl::irq_group_priority< app_resources, typename usart_type::irq >::value ==
+     mpl::irq_group_priority< app_resources, typename dma_rx::irq >::value) >;
+
+  /**
+   * Start DMA transmission of tx_fifo (if not already running).
+   */
+  static void flush() {
+    if(!tx_busy.exchange(true)) {
+      if(!start_tx())
+        tx_busy.store(false);
+    }
+  }
+
+  /**
+   * open the stream
+   *
+   *   - setup DMA channel for transmission
+   *   - setup and start circular DMA reception into rx_fifo (rx_dma only)
+   *   - enable USARTx
+   *   - enable usart and DMA irq channels
+   *   - enable RXNE (resp. IDLE if rx_dma is set) and PE interrupts
+   *
+   * NOTE: Make sure the device is correctly setup before calling this
+   *       function. e.g. by calling usart_device.configure()
+   */
+  static void open(void) {
+    tx_fifo.reset();
+    rx_fifo.reset();
+    tx_dma_count = 0;
+    tx_busy.store(false);
+    rx_overrun = 0;
+    rx_dma_index = 0;
+
+    dma_tx::template configure<
+      typename dma_tx::direction::memory_to_peripheral,
+      typename dma_tx::memory_increment,
+      typename dma_tx::transfer_complete_interrupt,
+      typename dma_tx::transfer_error_interrupt
+      >();
+    dma_tx::set_peripheral_address(usart_type::data_register_addr);
+    dma_tx::clear_flags();
+
+    if(rx_dma) {
+      dma_rx::template configure<
+        typename dma_rx::direction::peripheral_to_memory,
+        typename dma_rx::memory_increment,
+        typename dma_rx::circular_mode,
+        typename dma_rx::half_transfer_interrupt,
+        typename dma_rx::transfer_complete_interrupt,
+        typename dma_rx::transfer_error_interrupt
+        >();
+      dma_rx::set_peripheral_address(usart_type::data_register_addr);
+      dma_rx::set_memory_address(rx_fifo.data());
+      dma_rx::set_count(rx_fifo_type::buffer_size);
+      dma_rx::clear_flags();
+      dma_rx::enable();
+    }
+
+    usart_type::enable();
+    usart_type::enable_dma_tx();
+    dma_tx::irq::enable();
+    if(rx_dma) {
+      usart_type::enable_dma_rx();
+      dma_rx::irq::enable();
+    }
+    usart_type::irq::enable();
+    usart_type::enable_interrupt(!rx_dma, false, true, false, rx_dma);
+  }
+
+  /**
+   * close the stream
+   *
+   *   - disable interrupts enabled by open()
+   *   - disable the usartX and DMA irqs
+   *   - disable DMA transmission (and reception)
+   *   - disable USARTx
+   */
+  static void close(void) {
+    usart_type::disable_interrupt(!rx_dma, false, true, false, rx_dma);
+    usart_type::irq::disable();
+    dma_tx::irq::disable();
+    dma_tx::disable();
+    usart_type::disable_dma_tx();
+    if(rx_dma) {
+      dma_rx::irq::disable();
+      dma_rx::disable();
+      usart_type::disable_dma_rx();
+    }
+    usart_type::disable();
+  }
+};
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+rx_fifo_type usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::rx_fifo;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+fifo_type usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::tx_fifo;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+volatile unsigned int usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::irq_count;
+
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+volatile unsigned int usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::irq_errors;
 
-template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs>
-fifo_type usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs>::tx_fifo;
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+unsigned int usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::tx_dma_count;
 
-template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs>
-volatile unsigned int usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs>::irq_count;
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+std::atomic<bool> usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::tx_busy;
 
-template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs>
-volatile unsigned int usart_irq_stream<usart_type, fifo_type, crlf, debug_irqs>::irq_errors;
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+volatile unsigned int usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::rx_overrun;
 
+template<typename usart_type, typename fifo_type, bool crlf, bool debug_irqs, bool rx_dma, typename rx_fifo_type>
+unsigned int usart_dma_stream<usart_type, fifo_type, crlf, debug_irqs, rx_dma, rx_fifo_type>::rx_dma_index;
 
 } // namespace mptl
 
@@ -0,0 +1,250 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARCH_DMA_HPP_INCLUDED
+#define ARCH_DMA_HPP_INCLUDED
+
+#include <arch/nvic.hpp>
+#include <arch/rcc.hpp>
+#include <arch/reg/dma.hpp>
+#include <cstdint>
+
+namespace mptl {
+
+/**
+ * DMA channel.
+ *
+ * NOTE: The interface of this class is shared with dma_stream<> of
+ * the stm32f4xx architecture. Code using only the common functions
+ * and configuration traits (e.g. usart_dma_stream<>) is portable.
+ */
+template< unsigned _dma_no, unsigned _channel_no >
+class dma_channel
+{
+  static_assert((_channel_no >= 1) && (_channel_no <= 7), "invalid DMA channel number");
+
+public:
+
+  static constexpr unsigned dma_no     = _dma_no;
+  static constexpr unsigned channel_no = _channel_no;
+
+  using DMAx = DMA< dma_no >;
+  using CCR   = typename DMAx::template CHANNEL< channel_no >::CCR;
+  using CNDTR = typename DMAx::template CHANNEL< channel_no >::CNDTR;
+  using CPAR  = typename DMAx::template CHANNEL< channel_no >::CPAR;
+  using CMAR  = typename DMAx::template CHANNEL< channel_no >::CMAR;
+
+  using irq = irq::dma_channel< dma_no, channel_no >;
+
+  using resources = rcc_dma_clock_resources< dma_no >;
+
+private:
+
+  using ISR  = typename DMAx::ISR;
+  using IFCR = typename DMAx::IFCR;
+
+  template<unsigned value>
+  struct data_size_impl {
+    static_assert((value == 8) || (value == 16) || (value == 32), "illegal data size (supported values: 8, 16, 32)");
+    static constexpr unsigned bits = (value == 8) ? 0 : (value == 16) ? 1 : 2;
+  };
+
+public:  /* ------ configuration traits ------ */
+
+  struct direction {
+    using peripheral_to_memory = regval< typename CCR::DIR, 0 >;
+    using memory_to_peripheral = regval< typename CCR::DIR, 1 >;
+  };
+
+  struct priority {
+    using low       = regval< typename CCR::PL, 0 >;
+    using medium    = regval< typename CCR::PL, 1 >;
+    using high      = regval< typename CCR::PL, 2 >;
+    using very_high = regval< typename CCR::PL, 3 >;
+  };
+
+  template<unsigned bits>
+  using memory_size = regval< typename CCR::MSIZE, data_size_impl<bits>::bits >;
+
+  template<unsigned bits>
+  using peripheral_size = regval< typename CCR::PSIZE, data_size_impl<bits>::bits >;
+
+  using memory_increment     = regval< typename CCR::MINC, 1 >;
+  using peripheral_increment = regval< typename CCR::PINC, 1 >;
+  using circular_mode        = regval< typename CCR::CIRC, 1 >;
+
+  using transfer_complete_interrupt = regval< typename CCR::TCIE, 1 >;
+  using half_transfer_interrupt     = regval< typename CCR::HTIE, 1 >;
+  using transfer_error_interrupt    = regval< typename CCR::TEIE, 1 >;
+
+public:  /* ------ static member functions ------ */
+
+  /**
+   * Configure DMA channel register using Tp type traits.
+   *
+   * NOTE: disables the channel (no configuration traits for CCR::EN).
+   */
+  template< typename... Tp >
+  static void configure(void) {
+    reglist< Tp... >::template strict_reset_to< CCR >();
+  }
+
+  static void set_peripheral_address(uint32_t addr) {
+    CPAR::store(addr);
+  }
+
+  static void set_memory_address(void const volatile * addr) {
+#ifdef OPENMPTL_SIMULATION
+    sim_memory_address = const_cast<void *>(addr);
+#endif
+    CMAR::store(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(addr)));
+  }
+
+  /** NOTE: the channel must be disabled when calling this function */
+  static void set_count(unsigned int count) {
+#ifdef OPENMPTL_SIMULATION
+    sim_reload_count = count;
+#endif
+    CNDTR::store(count);
+  }
+
+  /** Number of data items remaining to be transferred */
+  static unsigned int get_count(void) {
+    return CNDTR::load();
+  }
+
+  static void enable(void) {
+    CCR::EN::set();
+  }
+  static void disable(void) {
+    CCR::EN::clear();
+  }
+  static bool is_enabled(void) {
+    return CCR::EN::test();
+  }
+  static bool is_circular(void) {
+    return CCR::CIRC::test();
+  }
+
+  static bool transfer_complete(void) {
+    return ISR::template TCIF< channel_no >::test();
+  }
+  static bool half_transfer(void) {
+    return ISR::template HTIF< channel_no >::test();
+  }
+  static bool transfer_error(void) {
+    return ISR::template TEIF< channel_no >::test();
+  }
+
+  static void clear_flags(void) {
+    IFCR::store(IFCR::template CGIF< channel_no >::value |
+                IFCR::template CTCIF< channel_no >::value |
+                IFCR::template CHTIF< channel_no >::value |
+                IFCR::template CTEIF< channel_no >::value);
+#ifdef OPENMPTL_SIMULATION
+    ISR::reg_value &= ~(ISR::template GIF< channel_no >::value |
+                        ISR::template TCIF< channel_no >::value |
+                        ISR::template HTIF< channel_no >::value |
+                        ISR::template TEIF< channel_no >::value);
+#endif
+  }
+
+#ifdef OPENMPTL_SIMULATION
+  /* host memory address (the 32bit CMAR register cannot hold host pointers) */
+  static void * sim_memory_address;
+
+  /* number of data items set by set_count(), reload value in circular mode */
+  static unsigned int sim_reload_count;
+
+  /**
+   * Simulate the DMA controller: transfer up to max_count data items
+   * of type Tp, by calling func(Tp & item) for each memory location
+   * (read item on memory_to_peripheral, write item on
+   * peripheral_to_memory). Sets the transfer flags, and reloads the
+   * counter in circular mode.
+   *
+   * Returns the number of data items transferred.
+   */
+  template<typename Tp, typename F>
+  static unsigned int sim_transfer(F && func, unsigned int max_count = ~0u) {
+    unsigned int n = 0;
+    while((n < max_count) && is_enabled()) {
+      unsigned int count = get_count();
+      if(count == 0)
+        break;  /* channel stays enabled after transfer complete */
+
+      func(static_cast<Tp *>(sim_memory_address)[sim_reload_count - count]);
+      n++;
+      count--;
+
+      typename ISR::value_type flags = ISR::template GIF< channel_no >::value;
+      if(count == sim_reload_count / 2)
+        flags |= ISR::template HTIF< channel_no >::value;
+      if(count == 0) {
+        flags |= ISR::template TCIF< channel_no >::value;
+        if(is_circular())
+          count = sim_reload_count;
+      }
+      ISR::reg_value |= flags;
+      CNDTR::store(count);
+    }
+    return n;
+  }
+
+  /** true if the simulated hardware would raise an interrupt */
+  static bool sim_irq_pending(void) {
+    return (transfer_complete() && CCR::TCIE::test()) ||
+      (half_transfer()     && CCR::HTIE::test()) ||
+      (transfer_error()    && CCR::TEIE::test());
+  }
+#endif // OPENMPTL_SIMULATION
+};
+
+#ifdef OPENMPTL_SIMULATION
+template< unsigned dma_no, unsigned channel_no >
+void * dma_channel<dma_no, channel_no>::sim_memory_address;
+
+template< unsigned dma_no, unsigned channel_no >
+unsigned int dma_channel<dma_no, channel_no>::sim_reload_count;
+#endif // OPENMPTL_SIMULATION
+
+
+/**
+ * DMA request mapping for USART peripherals (see RM0008, "DMA1
+ * request mapping").
+ */
+template< unsigned usart_no > struct usart_dma;
+
+template<> struct usart_dma<1> {
+  using tx = dma_channel< 1, 4 >;
+  using rx = dma_channel< 1, 5 >;
+};
+template<> struct usart_dma<2> {
+  using tx = dma_channel< 1, 7 >;
+  using rx = dma_channel< 1, 6 >;
+};
+template<> struct usart_dma<3> {
+  using tx = dma_channel< 1, 2 >;
+  using rx = dma_channel< 1, 3 >;
+};
+
+} // namespace mptl
+
+#endif // ARCH_DMA_HPP_INCLUDED
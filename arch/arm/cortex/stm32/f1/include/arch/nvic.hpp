@@ -296,6 +296,20 @@ template<> class spi<1> : public spi1 { };
 template<> class spi<2> : public spi2 { };
 //  template<> class spi<3> : public spi3 { };
 
+template<unsigned dma_no, unsigned channel_no> class dma_channel;
+template<> class dma_channel<1, 1> : public dma1_channel1 { };
+template<> class dma_channel<1, 2> : public dma1_channel2 { };
+template<> class dma_channel<1, 3> : public dma1_channel3 { };
+template<> class dma_channel<1, 4> : public dma1_channel4 { };
+template<> class dma_channel<1, 5> : public dma1_channel5 { };
+template<> class dma_channel<1, 6> : public dma1_channel6 { };
+template<> class dma_channel<1, 7> : public dma1_channel7 { };
+
+/** number of implemented priority bits (IPR/SHPR bits [7:4]) */
+static constexpr unsigned priority_bits = 4;
+
 } } // namespace mptl::irq
 
+#include "../../../../common/nvic_priority.hpp"
+
 #endif // ARCH_NVIC_HPP_INCLUDED
@@ -221,6 +221,7 @@ template<char>     struct rcc_gpio_clock_resources;
 template<unsigned> struct rcc_spi_clock_resources;
 template<unsigned> struct rcc_usart_clock_resources;
 template<unsigned> struct rcc_adc_clock_resources;
+template<unsigned> struct rcc_dma_clock_resources;
 
 using rcc_rtc_clock_resources = typelist<
   RCC::APB1ENR::PWREN,
@@ -262,6 +263,11 @@ template<> struct rcc_adc_clock_resources<2> : RCC::APB2ENR::ADC2EN { };
 template<> struct rcc_adc_clock_resources<1> : RCC::APB2ENR::ADC3EN { };
 #endif
 
+template<> struct rcc_dma_clock_resources<1> : RCC::AHBENR::DMA1EN { };
+#if defined (STM32F10X_HD) || defined (STM32F10X_XL) || defined (STM32F10X_CL) || defined (STM32F10X_HD_VL)
+template<> struct rcc_dma_clock_resources<2> : RCC::AHBENR::DMA2EN { };
+#endif
+
 } // namespace mptl
 
 #endif // ARCH_RCC_HPP_INCLUDED
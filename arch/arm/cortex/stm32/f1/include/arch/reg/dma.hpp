@@ -0,0 +1,144 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * This program contains derivative representations of CMSIS System
+ * View Description (SVD) files, and is subject to the "End User
+ * License Agreement for STMicroelectronics" (see "STM_License.html"
+ * in the containing directory).
+ */
+
+#ifndef ARCH_REG_DMA_HPP_INCLUDED
+#define ARCH_REG_DMA_HPP_INCLUDED
+
+#include <register.hpp>
+
+namespace mptl {
+
+/**
+ * DMA controller
+ */
+template<reg_addr_t base_addr>
+struct DMA_common
+{
+  /**
+   * DMA interrupt status register
+   */
+  struct ISR
+  : public reg< uint32_t, base_addr + 0x00, ro, 0x00000000 >
+  {
+    using type = reg< uint32_t, base_addr + 0x00, ro, 0x00000000 >;
+
+    template<unsigned channel_no> using GIF   = regbits< type, (channel_no - 1) * 4 + 0,  1 >;  /**< Channel x Global interrupt flag        */
+    template<unsigned channel_no> using TCIF  = regbits< type, (channel_no - 1) * 4 + 1,  1 >;  /**< Channel x Transfer Complete flag       */
+    template<unsigned channel_no> using HTIF  = regbits< type, (channel_no - 1) * 4 + 2,  1 >;  /**< Channel x Half Transfer Complete flag  */
+    template<unsigned channel_no> using TEIF  = regbits< type, (channel_no - 1) * 4 + 3,  1 >;  /**< Channel x Transfer Error flag          */
+  };
+
+  /**
+   * DMA interrupt flag clear register
+   */
+  struct IFCR
+  : public reg< uint32_t, base_addr + 0x04, wo, 0x00000000 >
+  {
+    using type = reg< uint32_t, base_addr + 0x04, wo, 0x00000000 >;
+
+    template<unsigned channel_no> using CGIF  = regbits< type, (channel_no - 1) * 4 + 0,  1 >;  /**< Channel x Global interrupt clear        */
+    template<unsigned channel_no> using CTCIF = regbits< type, (channel_no - 1) * 4 + 1,  1 >;  /**< Channel x Transfer Complete clear       */
+    template<unsigned channel_no> using CHTIF = regbits< type, (channel_no - 1) * 4 + 2,  1 >;  /**< Channel x Half Transfer clear           */
+    template<unsigned channel_no> using CTEIF = regbits< type, (channel_no - 1) * 4 + 3,  1 >;  /**< Channel x Transfer Error clear          */
+  };
+
+  /**
+   * DMA channel x registers (channel_no = 1..7)
+   */
+  template<unsigned channel_no>
+  struct CHANNEL
+  {
+    static constexpr reg_addr_t channel_addr = base_addr + 0x08 + (channel_no - 1) * 20;
+
+    /**
+     * DMA channel x configuration register
+     */
+    struct CCR
+    : public reg< uint32_t, channel_addr + 0x00, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, channel_addr + 0x00, rw, 0x00000000 >;
+
+      using MEM2MEM  = regbits< type, 14,  1 >;  /**< Memory to memory mode         */
+      using PL       = regbits< type, 12,  2 >;  /**< Channel Priority level        */
+      using MSIZE    = regbits< type, 10,  2 >;  /**< Memory size                   */
+      using PSIZE    = regbits< type,  8,  2 >;  /**< Peripheral size               */
+      using MINC     = regbits< type,  7,  1 >;  /**< Memory increment mode         */
+      using PINC     = regbits< type,  6,  1 >;  /**< Peripheral increment mode     */
+      using CIRC     = regbits< type,  5,  1 >;  /**< Circular mode                 */
+      using DIR      = regbits< type,  4,  1 >;  /**< Data transfer direction       */
+      using TEIE     = regbits< type,  3,  1 >;  /**< Transfer error interrupt enable     */
+      using HTIE     = regbits< type,  2,  1 >;  /**< Half Transfer interrupt enable      */
+      using TCIE     = regbits< type,  1,  1 >;  /**< Transfer complete interrupt enable  */
+      using EN       = regbits< type,  0,  1 >;  /**< Channel enable                */
+    };
+
+    /**
+     * DMA channel x number of data register
+     */
+    struct CNDTR
+    : public reg< uint32_t, channel_addr + 0x04, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, channel_addr + 0x04, rw, 0x00000000 >;
+
+      using NDT      = regbits< type,  0, 16 >;  /**< Number of data to transfer   */
+    };
+
+    /**
+     * DMA channel x peripheral address register
+     */
+    struct CPAR
+    : public reg< uint32_t, channel_addr + 0x08, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, channel_addr + 0x08, rw, 0x00000000 >;
+    };
+
+    /**
+     * DMA channel x memory address register
+     */
+    struct CMAR
+    : public reg< uint32_t, channel_addr + 0x0c, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, channel_addr + 0x0c, rw, 0x00000000 >;
+    };
+  };
+};
+
+template<unsigned dma_no>
+class DMA
+{
+  /* See available template specialisations below if the compiler asserts here! */
+  static_assert(dma_no == !dma_no, "unsupported DMA number");  // assertion needs to be dependent of template parameter
+};
+
+template<> class DMA<1> : public DMA_common< 0x40020000 > { };
+#if defined (STM32F10X_HD) || defined (STM32F10X_XL) || defined (STM32F10X_CL) || defined (STM32F10X_HD_VL)
+template<> class DMA<2> : public DMA_common< 0x40020400 > { };
+#endif
+
+} // namespace mptl
+
+#endif // ARCH_REG_DMA_HPP_INCLUDED
@@ -0,0 +1,276 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARCH_DMA_HPP_INCLUDED
+#define ARCH_DMA_HPP_INCLUDED
+
+#include <arch/nvic.hpp>
+#include <arch/rcc.hpp>
+#include <arch/reg/dma.hpp>
+#include <type_traits>
+#include <cstdint>
+
+namespace mptl {
+
+/**
+ * DMA stream, connected to the peripheral request given by
+ * channel_no (see RM0090, "DMA request mapping").
+ *
+ * NOTE: The interface of this class is shared with dma_channel<> of
+ * the stm32f10x architecture. Code using only the common functions
+ * and configuration traits (e.g. usart_dma_stream<>) is portable.
+ */
+template< unsigned _dma_no, unsigned _stream_no, unsigned _channel_no >
+class dma_stream
+{
+  static_assert(_stream_no <= 7, "invalid DMA stream number");
+  static_assert(_channel_no <= 7, "invalid DMA channel number");
+
+public:
+
+  static constexpr unsigned dma_no     = _dma_no;
+  static constexpr unsigned stream_no  = _stream_no;
+  static constexpr unsigned channel_no = _channel_no;
+
+  using DMAx = DMA< dma_no >;
+  using CR   = typename DMAx::template STREAM< stream_no >::CR;
+  using NDTR = typename DMAx::template STREAM< stream_no >::NDTR;
+  using PAR  = typename DMAx::template STREAM< stream_no >::PAR;
+  using M0AR = typename DMAx::template STREAM< stream_no >::M0AR;
+  using FCR  = typename DMAx::template STREAM< stream_no >::FCR;
+
+  using irq = irq::dma_stream< dma_no, stream_no >;
+
+  using resources = rcc_dma_clock_resources< dma_no >;
+
+private:
+
+  /* streams 0..3 use LISR/LIFCR, streams 4..7 use HISR/HIFCR */
+  using ISR  = typename std::conditional< (stream_no < 4), typename DMAx::LISR,  typename DMAx::HISR  >::type;
+  using IFCR = typename std::conditional< (stream_no < 4), typename DMAx::LIFCR, typename DMAx::HIFCR >::type;
+
+  static constexpr unsigned flag_no = stream_no % 4;
+
+  template<unsigned value>
+  struct data_size_impl {
+    static_assert((value == 8) || (value == 16) || (value == 32), "illegal data size (supported values: 8, 16, 32)");
+    static constexpr unsigned bits = (value == 8) ? 0 : (value == 16) ? 1 : 2;
+  };
+
+public:  /* ------ configuration traits ------ */
+
+  struct direction {
+    using peripheral_to_memory = regval< typename CR::DIR, 0 >;
+    using memory_to_peripheral = regval< typename CR::DIR, 1 >;
+    using memory_to_memory     = regval< typename CR::DIR, 2 >;
+  };
+
+  struct priority {
+    using low       = regval< typename CR::PL, 0 >;
+    using medium    = regval< typename CR::PL, 1 >;
+    using high      = regval< typename CR::PL, 2 >;
+    using very_high = regval< typename CR::PL, 3 >;
+  };
+
+  template<unsigned bits>
+  using memory_size = regval< typename CR::MSIZE, data_size_impl<bits>::bits >;
+
+  template<unsigned bits>
+  using peripheral_size = regval< typename CR::PSIZE, data_size_impl<bits>::bits >;
+
+  using memory_increment     = regval< typename CR::MINC, 1 >;
+  using peripheral_increment = regval< typename CR::PINC, 1 >;
+  using circular_mode        = regval< typename CR::CIRC, 1 >;
+
+  using transfer_complete_interrupt = regval< typename CR::TCIE, 1 >;
+  using half_transfer_interrupt     = regval< typename CR::HTIE, 1 >;
+  using transfer_error_interrupt    = regval< typename CR::TEIE, 1 >;
+
+public:  /* ------ static member functions ------ */
+
+  /**
+   * Configure DMA stream register using Tp type traits. The channel
+   * selection (CR::CHSEL) is set from the channel_no template
+   * argument.
+   *
+   * NOTE: disables the stream (no configuration traits for CR::EN).
+   * Make sure the stream is disabled when calling this function.
+   */
+  template< typename... Tp >
+  static void configure(void) {
+    reglist< regval< typename CR::CHSEL, channel_no >, Tp... >::template strict_reset_to< CR >();
+  }
+
+  static void set_peripheral_address(uint32_t addr) {
+    PAR::store(addr);
+  }
+
+  static void set_memory_address(void const volatile * addr) {
+#ifdef OPENMPTL_SIMULATION
+    sim_memory_address = const_cast<void *>(addr);
+#endif
+    M0AR::store(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(addr)));
+  }
+
+  /** NOTE: the stream must be disabled when calling this function */
+  static void set_count(unsigned int count) {
+#ifdef OPENMPTL_SIMULATION
+    sim_reload_count = count;
+#endif
+    NDTR::store(count);
+  }
+
+  /** Number of data items remaining to be transferred */
+  static unsigned int get_count(void) {
+    return NDTR::load();
+  }
+
+  static void enable(void) {
+    CR::EN::set();
+  }
+
+  /**
+   * Disable the stream, and wait until it is effectively disabled
+   * (the current data transfer is finished).
+   */
+  static void disable(void) {
+    CR::EN::clear();
+    while(CR::EN::test());
+  }
+
+  /** NOTE: the hardware clears CR::EN at the end of a (non-circular) transfer */
+  static bool is_enabled(void) {
+    return CR::EN::test();
+  }
+  static bool is_circular(void) {
+    return CR::CIRC::test();
+  }
+
+  static bool transfer_complete(void) {
+    return ISR::template TCIF< flag_no >::test();
+  }
+  static bool half_transfer(void) {
+    return ISR::template HTIF< flag_no >::test();
+  }
+  static bool transfer_error(void) {
+    return ISR::template TEIF< flag_no >::test();
+  }
+
+  static void clear_flags(void) {
+    IFCR::store(IFCR::template CFEIF< flag_no >::value |
+                IFCR::template CDMEIF< flag_no >::value |
+                IFCR::template CTEIF< flag_no >::value |
+                IFCR::template CHTIF< flag_no >::value |
+                IFCR::template CTCIF< flag_no >::value);
+#ifdef OPENMPTL_SIMULATION
+    ISR::reg_value &= ~(ISR::template FEIF< flag_no >::value |
+                        ISR::template DMEIF< flag_no >::value |
+                        ISR::template TEIF< flag_no >::value |
+                        ISR::template HTIF< flag_no >::value |
+                        ISR::template TCIF< flag_no >::value);
+#endif
+  }
+
+#ifdef OPENMPTL_SIMULATION
+  /* host memory address (the 32bit M0AR register cannot hold host pointers) */
+  static void * sim_memory_address;
+
+  /* number of data items set by set_count(), reload value in circular mode */
+  static unsigned int sim_reload_count;
+
+  /**
+   * Simulate the DMA controller: transfer up to max_count data items
+   * of type Tp, by calling func(Tp & item) for each memory location
+   * (read item on memory_to_peripheral, write item on
+   * peripheral_to_memory). Sets the transfer flags, and reloads the
+   * counter in circular mode (resp. disables the stream otherwise).
+   *
+   * Returns the number of data items transferred.
+   */
+  template<typename Tp, typename F>
+  static unsigned int sim_transfer(F && func, unsigned int max_count = ~0u) {
+    unsigned int n = 0;
+    while((n < max_count) && is_enabled()) {
+      unsigned int count = get_count();
+
+      func(static_cast<Tp *>(sim_memory_address)[sim_reload_count - count]);
+      n++;
+      count--;
+
+      typename ISR::value_type flags = 0;
+      if(count == sim_reload_count / 2)
+        flags |= ISR::template HTIF< flag_no >::value;
+      if(count == 0) {
+        flags |= ISR::template TCIF< flag_no >::value;
+        if(is_circular())
+          count = sim_reload_count;
+        else
+          CR::EN::clear();
+      }
+      ISR::reg_value |= flags;
+      NDTR::store(count);
+    }
+    return n;
+  }
+
+  /** true if the simulated hardware would raise an interrupt */
+  static bool sim_irq_pending(void) {
+    return (transfer_complete() && CR::TCIE::test()) ||
+      (half_transfer()     && CR::HTIE::test()) ||
+      (transfer_error()    && CR::TEIE::test());
+  }
+#endif // OPENMPTL_SIMULATION
+};
+
+#ifdef OPENMPTL_SIMULATION
+template< unsigned dma_no, unsigned stream_no, unsigned channel_no >
+void * dma_stream<dma_no, stream_no, channel_no>::sim_memory_address;
+
+template< unsigned dma_no, unsigned stream_no, unsigned channel_no >
+unsigned int dma_stream<dma_no, stream_no, channel_no>::sim_reload_count;
+#endif // OPENMPTL_SIMULATION
+
+
+/**
+ * DMA request mapping for USART peripherals (see RM0090, "DMA1/DMA2
+ * request mapping").
+ */
+template< unsigned usart_no > struct usart_dma;
+
+template<> struct usart_dma<1> {
+  using tx = dma_stream< 2, 7, 4 >;
+  using rx = dma_stream< 2, 2, 4 >;
+};
+template<> struct usart_dma<2> {
+  using tx = dma_stream< 1, 6, 4 >;
+  using rx = dma_stream< 1, 5, 4 >;
+};
+template<> struct usart_dma<3> {
+  using tx = dma_stream< 1, 3, 4 >;
+  using rx = dma_stream< 1, 1, 4 >;
+};
+template<> struct usart_dma<6> {
+  using tx = dma_stream< 2, 6, 5 >;
+  using rx = dma_stream< 2, 1, 5 >;
+};
+
+} // namespace mptl
+
+#endif // ARCH_DMA_HPP_INCLUDED
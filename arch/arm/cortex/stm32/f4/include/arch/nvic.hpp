@@ -120,8 +120,31 @@ template<> class spi<1> : public spi1 { };
 template<> class spi<2> : public spi2 { };
 template<> class spi<3> : public spi3 { };
 
+template<unsigned dma_no, unsigned stream_no> class dma_stream;
+template<> class dma_stream<1, 0> : public dma1_stream0 { };
+template<> class dma_stream<1, 1> : public dma1_stream1 { };
+template<> class dma_stream<1, 2> : public dma1_stream2 { };
+template<> class dma_stream<1, 3> : public dma1_stream3 { };
+template<> class dma_stream<1, 4> : public dma1_stream4 { };
+template<> class dma_stream<1, 5> : public dma1_stream5 { };
+template<> class dma_stream<1, 6> : public dma1_stream6 { };
+template<> class dma_stream<1, 7> : public dma1_stream7 { };
+template<> class dma_stream<2, 0> : public dma2_stream0 { };
+template<> class dma_stream<2, 1> : public dma2_stream1 { };
+template<> class dma_stream<2, 2> : public dma2_stream2 { };
+template<> class dma_stream<2, 3> : public dma2_stream3 { };
+template<> class dma_stream<2, 4> : public dma2_stream4 { };
+template<> class dma_stream<2, 5> : public dma2_stream5 { };
+template<> class dma_stream<2, 6> : public dma2_stream6 { };
+template<> class dma_stream<2, 7> : public dma2_stream7 { };
+
 static constexpr int numof_interrupt_channels = 82;
 
+/** number of implemented priority bits (IPR/SHPR bits [7:4]) */
+static constexpr unsigned priority_bits = 4;
+
 } } // namespace mptl::irq
 
+#include "../../../../common/nvic_priority.hpp"
+
 #endif // ARCH_NVIC_HPP_INCLUDED
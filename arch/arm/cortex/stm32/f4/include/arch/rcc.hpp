@@ -197,6 +197,7 @@ struct system_clock_hse
 /* Clock resource declarations (enable peripheral clocks) */
 template<char>     struct rcc_gpio_clock_resources;
 template<unsigned> struct rcc_usart_clock_resources;
+template<unsigned> struct rcc_dma_clock_resources;
 
 /*
  * Clock resource specialisation (enable peripheral clocks)
@@ -216,6 +217,9 @@ template<> struct rcc_usart_clock_resources<2>  : RCC::APB1ENR::USART2EN { };
 template<> struct rcc_usart_clock_resources<3>  : RCC::APB1ENR::USART3EN { };
 template<> struct rcc_usart_clock_resources<6>  : RCC::APB2ENR::USART6EN { };
 
+template<> struct rcc_dma_clock_resources<1>    : RCC::AHB1ENR::DMA1EN { };
+template<> struct rcc_dma_clock_resources<2>    : RCC::AHB1ENR::DMA2EN { };
+
 } // namespace mptl
 
 #endif // ARCH_RCC_HPP_INCLUDED
@@ -0,0 +1,213 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * This program contains derivative representations of CMSIS System
+ * View Description (SVD) files, and is subject to the "End User
+ * License Agreement for STMicroelectronics" (see "STM_License.html"
+ * in the containing directory).
+ */
+
+#ifndef ARCH_REG_DMA_HPP_INCLUDED
+#define ARCH_REG_DMA_HPP_INCLUDED
+
+#include <register.hpp>
+
+namespace mptl {
+
+namespace mpl
+{
+  /** bit offset of the stream flags within LISR/HISR (resp. LIFCR/HIFCR) */
+  static constexpr unsigned dma_stream_flag_offset(unsigned stream_no) {
+    return ((stream_no & 1) ? 6 : 0) + ((stream_no & 2) ? 16 : 0);
+  }
+} // namespace mpl
+
+
+/**
+ * DMA controller
+ */
+template<reg_addr_t base_addr>
+struct DMA_common
+{
+  /**
+   * Low interrupt status register (streams 0..3)
+   */
+  struct LISR
+  : public reg< uint32_t, base_addr + 0x00, ro, 0x00000000 >
+  {
+    using type = reg< uint32_t, base_addr + 0x00, ro, 0x00000000 >;
+
+    template<unsigned stream_no> using FEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 0, 1 >;  /**< Stream x FIFO error interrupt flag          */
+    template<unsigned stream_no> using DMEIF = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 2, 1 >;  /**< Stream x direct mode error interrupt flag   */
+    template<unsigned stream_no> using TEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 3, 1 >;  /**< Stream x transfer error interrupt flag      */
+    template<unsigned stream_no> using HTIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 4, 1 >;  /**< Stream x half transfer interrupt flag       */
+    template<unsigned stream_no> using TCIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 5, 1 >;  /**< Stream x transfer complete interrupt flag   */
+  };
+
+  /**
+   * High interrupt status register (streams 4..7)
+   */
+  struct HISR
+  : public reg< uint32_t, base_addr + 0x04, ro, 0x00000000 >
+  {
+    using type = reg< uint32_t, base_addr + 0x04, ro, 0x00000000 >;
+
+    template<unsigned stream_no> using FEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 0, 1 >;  /**< Stream x FIFO error interrupt flag          */
+    template<unsigned stream_no> using DMEIF = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 2, 1 >;  /**< Stream x direct mode error interrupt flag   */
+    template<unsigned stream_no> using TEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 3, 1 >;  /**< Stream x transfer error interrupt flag      */
+    template<unsigned stream_no> using HTIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 4, 1 >;  /**< Stream x half transfer interrupt flag       */
+    template<unsigned stream_no> using TCIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 5, 1 >;  /**< Stream x transfer complete interrupt flag   */
+  };
+
+  /**
+   * Low interrupt flag clear register (streams 0..3)
+   */
+  struct LIFCR
+  : public reg< uint32_t, base_addr + 0x08, rw, 0x00000000 >
+  {
+    using type = reg< uint32_t, base_addr + 0x08, rw, 0x00000000 >;
+
+    template<unsigned stream_no> using CFEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 0, 1 >;  /**< Stream x clear FIFO error interrupt flag          */
+    template<unsigned stream_no> using CDMEIF = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 2, 1 >;  /**< Stream x clear direct mode error interrupt flag   */
+    template<unsigned stream_no> using CTEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 3, 1 >;  /**< Stream x clear transfer error interrupt flag      */
+    template<unsigned stream_no> using CHTIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 4, 1 >;  /**< Stream x clear half transfer interrupt flag       */
+    template<unsigned stream_no> using CTCIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 5, 1 >;  /**< Stream x clear transfer complete interrupt flag   */
+  };
+
+  /**
+   * High interrupt flag clear register (streams 4..7)
+   */
+  struct HIFCR
+  : public reg< uint32_t, base_addr + 0x0c, rw, 0x00000000 >
+  {
+    using type = reg< uint32_t, base_addr + 0x0c, rw, 0x00000000 >;
+
+    template<unsigned stream_no> using CFEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 0, 1 >;  /**< Stream x clear FIFO error interrupt flag          */
+    template<unsigned stream_no> using CDMEIF = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 2, 1 >;  /**< Stream x clear direct mode error interrupt flag   */
+    template<unsigned stream_no> using CTEIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 3, 1 >;  /**< Stream x clear transfer error interrupt flag      */
+    template<unsigned stream_no> using CHTIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 4, 1 >;  /**< Stream x clear half transfer interrupt flag       */
+    template<unsigned stream_no> using CTCIF  = regbits< type, mpl::dma_stream_flag_offset(stream_no) + 5, 1 >;  /**< Stream x clear transfer complete interrupt flag   */
+  };
+
+  /**
+   * DMA stream x registers (stream_no = 0..7)
+   */
+  template<unsigned stream_no>
+  struct STREAM
+  {
+    static constexpr reg_addr_t stream_addr = base_addr + 0x10 + stream_no * 0x18;
+
+    /**
+     * Stream x configuration register
+     */
+    struct CR
+    : public reg< uint32_t, stream_addr + 0x00, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, stream_addr + 0x00, rw, 0x00000000 >;
+
+      using CHSEL   = regbits< type, 25,  3 >;  /**< Channel selection                      */
+      using MBURST  = regbits< type, 23,  2 >;  /**< Memory burst transfer configuration    */
+      using PBURST  = regbits< type, 21,  2 >;  /**< Peripheral burst transfer configuration  */
+      using CT      = regbits< type, 19,  1 >;  /**< Current target (only in double buffer mode)  */
+      using DBM     = regbits< type, 18,  1 >;  /**< Double buffer mode                     */
+      using PL      = regbits< type, 16,  2 >;  /**< Priority level                         */
+      using PINCOS  = regbits< type, 15,  1 >;  /**< Peripheral increment offset size       */
+      using MSIZE   = regbits< type, 13,  2 >;  /**< Memory data size                       */
+      using PSIZE   = regbits< type, 11,  2 >;  /**< Peripheral data size                   */
+      using MINC    = regbits< type, 10,  1 >;  /**< Memory increment mode                  */
+      using PINC    = regbits< type,  9,  1 >;  /**< Peripheral increment mode              */
+      using CIRC    = regbits< type,  8,  1 >;  /**< Circular mode                          */
+      using DIR     = regbits< type,  6,  2 >;  /**< Data transfer direction                */
+      using PFCTRL  = regbits< type,  5,  1 >;  /**< Peripheral flow controller             */
+      using TCIE    = regbits< type,  4,  1 >;  /**< Transfer complete interrupt enable     */
+      using HTIE    = regbits< type,  3,  1 >;  /**< Half transfer interrupt enable         */
+      using TEIE    = regbits< type,  2,  1 >;  /**< Transfer error interrupt enable        */
+      using DMEIE   = regbits< type,  1,  1 >;  /**< Direct mode error interrupt enable     */
+      using EN      = regbits< type,  0,  1 >;  /**< Stream enable / flag stream ready when read low  */
+    };
+
+    /**
+     * Stream x number of data register
+     */
+    struct NDTR
+    : public reg< uint32_t, stream_addr + 0x04, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, stream_addr + 0x04, rw, 0x00000000 >;
+
+      using NDT     = regbits< type,  0, 16 >;  /**< Number of data items to transfer       */
+    };
+
+    /**
+     * Stream x peripheral address register
+     */
+    struct PAR
+    : public reg< uint32_t, stream_addr + 0x08, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, stream_addr + 0x08, rw, 0x00000000 >;
+    };
+
+    /**
+     * Stream x memory 0 address register
+     */
+    struct M0AR
+    : public reg< uint32_t, stream_addr + 0x0c, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, stream_addr + 0x0c, rw, 0x00000000 >;
+    };
+
+    /**
+     * Stream x memory 1 address register
+     */
+    struct M1AR
+    : public reg< uint32_t, stream_addr + 0x10, rw, 0x00000000 >
+    {
+      using type = reg< uint32_t, stream_addr + 0x10, rw, 0x00000000 >;
+    };
+
+    /**
+     * Stream x FIFO control register
+     */
+    struct FCR
+    : public reg< uint32_t, stream_addr + 0x14, rw, 0x00000021 >
+    {
+      using type = reg< uint32_t, stream_addr + 0x14, rw, 0x00000021 >;
+
+      using FEIE    = regbits< type,  7,  1 >;  /**< FIFO error interrupt enable  */
+      using FS      = regbits< type,  3,  3 >;  /**< FIFO status                  */
+      using DMDIS   = regbits< type,  2,  1 >;  /**< Direct mode disable          */
+      using FTH     = regbits< type,  0,  2 >;  /**< FIFO threshold selection     */
+    };
+  };
+};
+
+template<unsigned dma_no>
+class DMA
+{
+  /* See available template specialisations below if the compiler asserts here! */
+  static_assert(dma_no == !dma_no, "unsupported DMA number");  // assertion needs to be dependent of template parameter
+};
+
+template<> class DMA<1> : public DMA_common< 0x40026000 > { };
+template<> class DMA<2> : public DMA_common< 0x40026400 > { };
+
+} // namespace mptl
+
+#endif // ARCH_REG_DMA_HPP_INCLUDED
@@ -0,0 +1,77 @@
+#!/usr/bin/perl
+
+#
+# decodes binary output of mptl::deferred_log::dump(), using the
+# format strings from the ".mptl_log" section of the (32bit,
+# little-endian) ELF executable.
+#
+# usage: log_decode.pl [-n <max_args>] <elf_file> [<log_file>]
+#
+# max_args: deferred_log<> template argument (default: 3)
+#
+
+use Getopt::Std;
+use strict;
+use warnings FATAL => qw( all );
+
+my %opts;
+getopts('n:', \%opts);
+my $max_args = $opts{n} // 3;
+my $elf_file = shift @ARGV;
+
+die "usage: $0 [-n <max_args>] <elf_file> [<log_file>]\n" unless($elf_file);
+
+# read .mptl_log section from ELF file
+open(my $elf_fh, '<:raw', $elf_file) or die "$elf_file: $!\n";
+my $elf = do { local $/; <$elf_fh> };
+close($elf_fh);
+
+die "$elf_file: not a 32bit little-endian ELF file\n"
+  unless(substr($elf, 0, 6) eq "\x7fELF\x01\x01");
+
+my ($shoff) = unpack('V', substr($elf, 0x20, 4));
+my ($shentsize, $shnum, $shstrndx) = unpack('v3', substr($elf, 0x2e, 6));
+
+my @sections = map { [ unpack('V10', substr($elf, $shoff + $_ * $shentsize, 40)) ] } (0 .. $shnum - 1);
+my $shstrtab = $sections[$shstrndx];
+
+my ($log_addr, $log_data);
+foreach my $sh (@sections) {
+  my ($name_off, undef, undef, $addr, $offset, $size) = @$sh;
+  my $name = unpack('Z*', substr($elf, $shstrtab->[4] + $name_off));
+  if($name eq '.mptl_log') {
+    $log_addr = $addr;
+    $log_data = substr($elf, $offset, $size);
+    last;
+  }
+}
+die "$elf_file: no .mptl_log section found\n" unless(defined($log_data));
+
+# decode records from log file (or stdin)
+my $record_size = 4 + 4 * $max_args;
+binmode(STDIN);
+local $/ = \$record_size;
+while(my $record = <>) {
+  last if(length($record) < $record_size);
+  my ($id, @args) = unpack('V*', $record);
+
+  my $pos = $id - $log_addr;
+  if(($pos < 0) || ($pos >= length($log_data))) {
+    printf("<invalid id: 0x%08x>\n", $id);
+    next;
+  }
+  my $fmt = unpack('Z*', substr($log_data, $pos));
+
+  # same conversions as deferred_log::format()
+  my $n = 0;
+  $fmt =~ s{%(0?)(\d*)([udxc%])}{
+    my ($flag, $width, $conv) = ($1, $2, $3);
+    if($conv eq '%') { '%' }
+    else {
+      my $val = $n < $max_args ? $args[$n++] : 0;
+      $val = unpack('l', pack('L', $val)) if($conv eq 'd');
+      sprintf("%${flag}${width}${conv}", $val);
+    }
+  }ge;
+  print "$fmt\n";
+}
@@ -8,6 +8,7 @@
 # Output variables:
 #
 # - OPENMPTL_INCLUDE : compiler include flags
+# - OPENMPTL_LD_PATH : linker search path (linker script fragments, INCLUDE)
 #
 
 OPENMPTL_DOC_DIR     = $(OPENMPTL_TOP)/doc
@@ -20,3 +21,6 @@ OPENMPTL_INCLUDE     = -I $(OPENMPTL_INCLUDE_DIR)
 OPENMPTL_INCLUDE    += -I $(OPENMPTL_DRIVERS_DIR)
 OPENMPTL_INCLUDE    += -I $(OPENMPTL_LIB_DIR)/include
 OPENMPTL_INCLUDE    += -I $(OPENMPTL_ARCH_DIR)/$(OPENMPTL_ARCH)/include
+
+OPENMPTL_LD_PATH     = -L $(OPENMPTL_ARCH_DIR)/arm/cortex/common/ld
+OPENMPTL_LD_PATH    += -L $(OPENMPTL_ARCH_DIR)/$(OPENMPTL_ARCH)/ld
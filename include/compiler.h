@@ -10,7 +10,10 @@
 
 // NOTE: While non-ASM statement in naked function is not supported,
 // it works fine in our projects (arm). Use with care!
-#ifdef CONFIG_CLANG
+// NOTE: Never use naked functions in simulation: on the host, the
+// missing prologue corrupts the stack (gcc >= 8 honors the attribute
+// on x86).
+#if defined(CONFIG_CLANG) || defined(OPENMPTL_SIMULATION)
 # define __naked                __attribute__((noinline))
 #else
 # define __naked                __attribute__((naked)) __attribute__((noinline))
@@ -23,4 +26,33 @@
 # define __used                  __attribute__((used))
 #endif
 
+/*
+ * Section attributes (memory placement)
+ *
+ * Sections are placed by the linker script fragments in
+ * arch/arm/cortex/common/ld/ and arch/arm/cortex/stm32/f4/ld/, and
+ * initialized by crt::init_data_regions() and crt::init_bss_regions().
+ *
+ * - __ram_function : execute function from RAM (copied on startup).
+ *                    Gives deterministic timing (no flash wait states).
+ *                    long_call: RAM is out of range for "bl" from flash.
+ * - __ccm_data     : initialized data in CCM (STM32F4 core coupled memory)
+ * - __ccm_bss      : zero-initialized data in CCM
+ * - __ccm_noinit   : uninitialized data in CCM (e.g. stacks)
+ *
+ * NOTE: CCM is not accessible by DMA.
+ * NOTE: Not applied in simulation (no linker script).
+ */
+#ifdef OPENMPTL_SIMULATION
+# define __ram_function
+# define __ccm_data
+# define __ccm_bss
+# define __ccm_noinit
+#else
+# define __ram_function          __attribute__((long_call, noinline, section(".ram_functions")))
+# define __ccm_data              __attribute__((section(".ccm_data")))
+# define __ccm_bss               __attribute__((section(".ccm_bss")))
+# define __ccm_noinit            __attribute__((section(".ccm")))
+#endif // OPENMPTL_SIMULATION
+
 #endif // COMPILER_H_INCLUDED
@@ -27,10 +27,155 @@
 #ifndef CRT_HPP_INCLUDED
 #define CRT_HPP_INCLUDED
 
-#ifndef OPENMPTL_SIMULATION
-
 #include <cstdint>
 
+namespace crt
+{
+  /** Initialized data region: copy [lma, lma + (end - start)) to [start, end) */
+  struct data_region {
+    const uint32_t * lma;  /* load memory address */
+    uint32_t * start;
+    uint32_t * end;
+  };
+
+  /** Zero-initialized data region [start, end) */
+  struct bss_region {
+    uint32_t * start;
+    uint32_t * end;
+  };
+
+  /**
+   * Copy words from src to [dst, end).
+   *
+   * Copies blocks of four words, followed by the remaining 0..3
+   * words. This quarters the loop overhead, and gives the compiler
+   * the chance to merge the accesses into LDM/STM bursts (gcc
+   * usually does at -O2/-Os, but this is not guaranteed: check the
+   * disassembly if it matters). All pointers must be word aligned
+   * (use ". = ALIGN(4)" in the linker script).
+   *
+   * Returns the number of words copied.
+   */
+  static inline uint32_t copy_words(uint32_t * dst, const uint32_t * src, const uint32_t * const end) {
+    uint32_t n = end - dst;
+    for(uint32_t i = n >> 2; i; i--) {
+      uint32_t w0 = src[0];
+      uint32_t w1 = src[1];
+      uint32_t w2 = src[2];
+      uint32_t w3 = src[3];
+      dst[0] = w0;
+      dst[1] = w1;
+      dst[2] = w2;
+      dst[3] = w3;
+      dst += 4;
+      src += 4;
+    }
+    switch(n & 3) {
+    case 3: *(dst++) = *(src++);  /* fallthrough */
+    case 2: *(dst++) = *(src++);  /* fallthrough */
+    case 1: *(dst++) = *(src++);
+    }
+    return n;
+  }
+
+  /** Zero [dst, end) (see copy_words() above) */
+  static inline uint32_t zero_words(uint32_t * dst, const uint32_t * const end) {
+    uint32_t n = end - dst;
+    for(uint32_t i = n >> 2; i; i--) {
+      dst[0] = 0;
+      dst[1] = 0;
+      dst[2] = 0;
+      dst[3] = 0;
+      dst += 4;
+    }
+    switch(n & 3) {
+    case 3: *(dst++) = 0;  /* fallthrough */
+    case 2: *(dst++) = 0;  /* fallthrough */
+    case 1: *(dst++) = 0;
+    }
+    return n;
+  }
+
+  /** Initialize all data regions in table [begin, end). Returns the number of words copied. */
+  static inline uint32_t init_data_regions(const data_region * begin, const data_region * end) {
+    uint32_t n = 0;
+    for(const data_region * r = begin; r < end; r++) {
+      if(r->start != r->lma)  /* skip regions executed in place */
+        n += copy_words(r->start, r->lma, r->end);
+    }
+    return n;
+  }
+
+  /** Zero all bss regions in table [begin, end). Returns the number of words zeroed. */
+  static inline uint32_t init_bss_regions(const bss_region * begin, const bss_region * end) {
+    uint32_t n = 0;
+    for(const bss_region * r = begin; r < end; r++)
+      n += zero_words(r->start, r->end);
+    return n;
+  }
+
+  /** true if [start, end) is word aligned and start <= end */
+  static inline bool region_valid(const uint32_t * start, const uint32_t * end) {
+    uintptr_t s = reinterpret_cast<uintptr_t>(start);
+    uintptr_t e = reinterpret_cast<uintptr_t>(end);
+    return !(s & 3) && !(e & 3) && (s <= e);
+  }
+
+  /** true if [a, a_end) and [b, b_end) overlap (empty regions never overlap) */
+  static inline bool regions_overlap(const uint32_t * a, const uint32_t * a_end, const uint32_t * b, const uint32_t * b_end) {
+    return (reinterpret_cast<uintptr_t>(a) < reinterpret_cast<uintptr_t>(b_end)) &&
+           (reinterpret_cast<uintptr_t>(b) < reinterpret_cast<uintptr_t>(a_end));
+  }
+
+  /** true if [start, end) overlaps the destination of any region in the tables */
+  static inline bool overlaps_any(const uint32_t * start, const uint32_t * end,
+                                  const data_region * data_begin, const data_region * data_end,
+                                  const bss_region * bss_begin, const bss_region * bss_end) {
+    for(const data_region * r = data_begin; r < data_end; r++) {
+      if(regions_overlap(start, end, r->start, r->end))
+        return true;
+    }
+    for(const bss_region * r = bss_begin; r < bss_end; r++) {
+      if(regions_overlap(start, end, r->start, r->end))
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * Check consistency of the region tables (e.g. in simulation or
+   * unittests, against a broken linker script):
+   *
+   *  - all regions (and load addresses) are word aligned, start <= end
+   *  - destinations of all regions are disjoint
+   *  - load images do not overlap any destination (would be
+   *    overwritten during initialization), except for regions
+   *    executed in place (lma == start)
+   */
+  static inline bool check_regions(const data_region * data_begin, const data_region * data_end,
+                                   const bss_region * bss_begin, const bss_region * bss_end) {
+    for(const data_region * r = data_begin; r < data_end; r++) {
+      if(!region_valid(r->start, r->end) || !region_valid(r->lma, r->lma))
+        return false;
+      if(overlaps_any(r->start, r->end, r + 1, data_end, bss_begin, bss_end))
+        return false;
+      if((r->start != r->lma) &&
+         overlaps_any(r->lma, r->lma + (r->end - r->start), data_begin, data_end, bss_begin, bss_end))
+        return false;
+    }
+    for(const bss_region * r = bss_begin; r < bss_end; r++) {
+      if(!region_valid(r->start, r->end))
+        return false;
+      if(overlaps_any(r->start, r->end, data_end, data_end, r + 1, bss_end))
+        return false;
+    }
+    return true;
+  }
+} // namespace crt
+
+
+#ifndef OPENMPTL_SIMULATION
+
 /* Make sure your linker script provides these: */
 extern uint32_t _data_lma; /* load address of data section */
 extern uint32_t _sdata;
@@ -44,19 +189,54 @@ extern void (*__init_array_end      []) (void);
 extern void (*__fini_array_start    []) (void);
 extern void (*__fini_array_end      []) (void);
 
+/*
+ * Region tables, needed by init_data_regions() and
+ * init_bss_regions() (e.g. for .ram_functions or CCM data/bss
+ * sections, see linker script fragments in arch/.../ld/). Example:
+ *
+ *     .crt_region_table :
+ *     {
+ *         . = ALIGN(4);
+ *         __data_region_table_start = .;
+ *         LONG(_data_lma)           LONG(_sdata)           LONG(_edata)
+ *         LONG(_ram_functions_lma)  LONG(_sram_functions)  LONG(_eram_functions)
+ *         __data_region_table_end = .;
+ *         __bss_region_table_start = .;
+ *         LONG(_sbss)               LONG(_ebss)
+ *         __bss_region_table_end = .;
+ *     } > FLASH
+ */
+extern const crt::data_region __data_region_table_start[];
+extern const crt::data_region __data_region_table_end[];
+extern const crt::bss_region  __bss_region_table_start[];
+extern const crt::bss_region  __bss_region_table_end[];
+
 namespace crt
 {
+  /** initialize data section (single region: _data_lma, _sdata, _edata) */
   static inline void init_data_section(void) {
-    uint32_t *src = &_data_lma;
-    uint32_t *dst = &_sdata;
-    while(dst < &_edata)
-      *(dst++) = *(src++);
+    copy_words(&_sdata, &_data_lma, &_edata);
   }
 
+  /** initialize bss section (single region: _sbss, _ebss) */
   static inline void init_bss_section(void) {
-    uint32_t *dst = &_sbss;
-    while(dst < &_ebss)
-      *(dst++) = 0;
+    zero_words(&_sbss, &_ebss);
+  }
+
+  /** initialize all data regions from linker region table */
+  static inline uint32_t init_data_regions(void) {
+    return init_data_regions(__data_region_table_start, __data_region_table_end);
+  }
+
+  /** initialize all bss regions from linker region table */
+  static inline uint32_t init_bss_regions(void) {
+    return init_bss_regions(__bss_region_table_start, __bss_region_table_end);
+  }
+
+  /** check consistency of linker region tables */
+  static inline bool check_regions(void) {
+    return check_regions(__data_region_table_start, __data_region_table_end,
+                         __bss_region_table_start, __bss_region_table_end);
   }
 
   /** call functions in preinit_array */
@@ -90,6 +270,9 @@ namespace crt
 {
   static inline void init_data_section(void) { }
   static inline void init_bss_section(void) { }
+  static inline uint32_t init_data_regions(void) { return 0; }
+  static inline uint32_t init_bss_regions(void) { return 0; }
+  static inline bool check_regions(void) { return true; }
   static inline void run_preinit_array(void) { }
   static inline void run_init_array(void) { }
   static inline void run_fini_array(void) { }
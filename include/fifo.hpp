@@ -53,6 +53,12 @@ class ring_buffer
   std::atomic<unsigned int> atomic_read_index;
   Tp buf[size];
 
+  /* overrun marker (see commit_write_index()): the producer bumps
+   * overrun_seq, the consumer sets overrun_ack after resync */
+  std::atomic<unsigned int> atomic_overrun_seq;
+  std::atomic<unsigned int> atomic_overrun_ack;
+  bool overrun_flag;  /* consumer-owned */
+
   unsigned int increment(unsigned int arg) {
     unsigned int ret = arg + 1;
     if(ret >= size)
@@ -60,6 +66,35 @@ class ring_buffer
     return ret;
   }
 
+  /** number of elements from index "from" up to index "to" (excluding) */
+  unsigned int distance(unsigned int from, unsigned int to) const {
+    return (to >= from) ? (to - from) : (to + size - from);
+  }
+
+  /** true if an overrun was published, which was not handled by the consumer yet */
+  bool overrun_pending(void) const {
+    return atomic_overrun_seq.load(std::memory_order_acquire) != atomic_overrun_ack.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Consumer only: handle an overrun published by the producer:
+   * move the read index to just behind the write index, keeping the
+   * most recent (size - 1) elements. Repeats if the producer
+   * published another overrun in the meantime.
+   */
+  void sync_overrun(void) {
+    if(!overrun_pending())
+      return;
+    unsigned int seq;
+    do {
+      seq = atomic_overrun_seq.load(std::memory_order_acquire);
+      unsigned int write_index = atomic_write_index.load(std::memory_order_acquire);
+      atomic_read_index.store(increment(write_index), std::memory_order_release);
+    } while(atomic_overrun_seq.load(std::memory_order_acquire) != seq);
+    atomic_overrun_ack.store(seq, std::memory_order_release);
+    overrun_flag = true;
+  }
+
 public:
 
 #if 0 // no constructor. read "why constructors suck for static member variables of template classes" (TODO)
@@ -76,6 +111,9 @@ public:
   void reset(void) {
     atomic_write_index.store(0, std::memory_order_relaxed);
     atomic_read_index.store(0, std::memory_order_relaxed);
+    atomic_overrun_seq.store(0, std::memory_order_relaxed);
+    atomic_overrun_ack.store(0, std::memory_order_relaxed);
+    overrun_flag = false;
   }
 
   bool push(Tp data) {
@@ -94,6 +132,7 @@ public:
 
   bool pop(Tp &data) {
     /* Consumer only: updates read_index after reading */
+    sync_overrun();
     unsigned int write_index = atomic_write_index.load(std::memory_order_acquire);
     unsigned int read_index = atomic_read_index.load(std::memory_order_acquire);
 
@@ -151,44 +190,289 @@ public:
     return true;
   }
 
-#if 0
+  /**
+   * Number of elements available for reading.
+   *
+   * NOTE: Safe to be called from both producer and consumer side,
+   * but the value might already be outdated when returned.
+   */
+  unsigned int read_available(void) const {
+    unsigned int write_index = atomic_write_index.load(std::memory_order_acquire);
+    unsigned int read_index = atomic_read_index.load(std::memory_order_acquire);
+    return distance(read_index, write_index);
+  }
+
+  /** Number of elements which can be pushed without overrun. */
+  unsigned int write_available(void) const {
+    return (size - 1) - read_available();
+  }
+
+  /**
+   * Producer only: returns a pointer to the next free slot, or
+   * nullptr if the buffer is full. The slot is published to the
+   * consumer by a subsequent call to commit_write().
+   */
+  Tp * prepare_write(void) {
+    unsigned int write_index = atomic_write_index.load(std::memory_order_relaxed);
+    if(increment(write_index) == atomic_read_index.load(std::memory_order_acquire)) {
+      return nullptr; /* buffer full */
+    }
+    return &buf[write_index];
+  }
+
+  /**
+   * Raw buffer storage, e.g. for use as destination of a circular DMA
+   * transfer (see commit_write_index()).
+   */
+  Tp * data(void) {
+    return buf;
+  }
+  static constexpr unsigned int buffer_size = size;
+
+  /**
+   * Producer only: publish all elements written to the buffer storage
+   * (data()) up to index (excluding), e.g. by a circular DMA transfer.
+   *
+   * count is the number of elements written since the last call. It
+   * cannot be derived from index alone if the writer completed a full
+   * lap of the buffer storage, which is why the caller has to provide
+   * it (e.g. by evaluating the DMA half/complete transfer flags).
+   *
+   * If more elements were written than slots were available
+   * (overrun), the writer has overwritten the oldest unread elements.
+   * The write index is set to index nevertheless, and an overrun
+   * marker is published: on its next call (pop(), peek(),
+   * read_region() or consume()), the consumer moves its read index to
+   * just behind the write index, keeping the most recent (size - 1)
+   * elements.
+   *
+   * NOTE: The writer does not wait for the consumer: elements read by
+   * the consumer right before the overrun marker is published might
+   * have been overwritten while being read (torn). Every such read is
+   * followed by an overrun marker: consumers which need to detect
+   * this call test_and_clear_overrun() after reading.
+   *
+   * Returns the number of elements lost (written but discarded).
+   */
+  unsigned int commit_write_index(unsigned int index, unsigned int count) {
+    unsigned int write_index = atomic_write_index.load(std::memory_order_relaxed);
+    unsigned int seq = atomic_overrun_seq.load(std::memory_order_relaxed);
+    unsigned int level = size - 1;  /* previous overrun not handled yet: fifo is full */
+    if(atomic_overrun_ack.load(std::memory_order_acquire) == seq)
+      level = distance(atomic_read_index.load(std::memory_order_acquire), write_index);
+
+    atomic_write_index.store(index, std::memory_order_release);
+    if(level + count < size)
+      return 0;
+
+    /* publish the overrun marker after the write index (see sync_overrun()) */
+    atomic_overrun_seq.store(seq + 1, std::memory_order_release);
+    return level + count - (size - 1);
+  }
 
-  int read_available() {
-    if (write_index >= read_index)
+  /** Producer only: publish the slot returned by prepare_write(). */
+  void commit_write(void) {
+    unsigned int write_index = atomic_write_index.load(std::memory_order_relaxed);
+    atomic_write_index.store(increment(write_index), std::memory_order_release);
+  }
+
+  /**
+   * Consumer only: returns a pointer to the n-th element available
+   * for reading (without removing it), or nullptr if less than n+1
+   * elements are available.
+   */
+  Tp * peek(unsigned int n = 0) {
+    sync_overrun();
+    unsigned int write_index = atomic_write_index.load(std::memory_order_acquire);
+    unsigned int read_index = atomic_read_index.load(std::memory_order_relaxed);
+    if(n >= distance(read_index, write_index)) {
+      return nullptr;
+    }
+    read_index += n;
+    if(read_index >= size)
+      read_index -= size;
+    return &buf[read_index];
+  }
+
+  /**
+   * Consumer only: provides the largest contiguous block of elements
+   * available for reading (e.g. for DMA transfers), which ends either
+   * at the write index or at the end of the buffer storage.
+   *
+   * Returns the number of elements in the block (0 if empty). The
+   * elements are released by a subsequent call to consume().
+   */
+  unsigned int read_region(Tp * & data) {
+    sync_overrun();
+    unsigned int write_index = atomic_write_index.load(std::memory_order_acquire);
+    unsigned int read_index = atomic_read_index.load(std::memory_order_relaxed);
+    data = &buf[read_index];
+    if(write_index >= read_index)
       return write_index - read_index;
-    return write_index + size - read_index;
+    return size - read_index;
+  }
+
+  /**
+   * Consumer only: release n elements (previously accessed using
+   * peek() or read_region()), handing the slots back to the producer.
+   *
+   * If an overrun was published in the meantime, the elements are
+   * already discarded: the read index is moved as on pop().
+   */
+  void consume(unsigned int n = 1) {
+    if(overrun_pending()) {
+      sync_overrun();
+      return;
+    }
+    unsigned int read_index = atomic_read_index.load(std::memory_order_relaxed) + n;
+    if(read_index >= size)
+      read_index -= size;
+    atomic_read_index.store(read_index, std::memory_order_release);
   }
 
-  int write_available() {
-    int ret = read_index - write_index - 1;
-    if (write_index >= read_index)
-      ret += size;
+  /**
+   * Consumer only: returns true if an overrun occurred (see
+   * commit_write_index()) since the last call, and clears the flag.
+   *
+   * If true, elements were discarded, and the elements read since the
+   * last call might be torn.
+   */
+  bool test_and_clear_overrun(void) {
+    sync_overrun();
+    bool ret = overrun_flag;
+    overrun_flag = false;
     return ret;
   }
-#endif
 };
 
 
 
+/**
+ * Statistics counter, owned (written) by exactly one side of a fifo
+ * (either producer or consumer).
+ *
+ * Since there is only a single writer, no read-modify-write on shared
+ * data is needed: the owner performs a plain load/store, which is
+ * safe to be called from an ISR on any Cortex-M core (no ldrex/strex
+ * or interrupt locking). Readers on the other side always get a
+ * consistent value.
+ */
+class fifo_counter
+{
+  std::atomic<unsigned int> value;
+
+public:
+
+  /** NOTE: owner side only */
+  void reset(void) {
+    value.store(0, std::memory_order_relaxed);
+  }
+
+  /** NOTE: owner side only */
+  void add(unsigned int n) {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  /** NOTE: owner side only */
+  void set(unsigned int n) {
+    value.store(n, std::memory_order_relaxed);
+  }
+
+  /** NOTE: owner side only */
+  void update_max(unsigned int n) {
+    if(n > value.load(std::memory_order_relaxed))
+      value.store(n, std::memory_order_relaxed);
+  }
+
+  unsigned int get(void) const {
+    return value.load(std::memory_order_relaxed);
+  }
+};
+
+
+/**
+ * Snapshot of the counted_ring_buffer<> statistics.
+ *
+ * Call update() periodically (e.g. once per second from the main
+ * loop) in order to get the number of overruns (dropped elements)
+ * since the last update in "overrun_delta".
+ */
+struct fifo_statistics
+{
+  unsigned int size;           /**< fifo capacity (size - 1)                       */
+  unsigned int level;          /**< number of elements in fifo                     */
+  unsigned int total;          /**< number of elements pushed                      */
+  unsigned int overrun;        /**< number of elements dropped (fifo full)         */
+  unsigned int underrun;       /**< number of pop() calls on empty fifo            */
+  unsigned int peak;           /**< high-water mark of fifo level                  */
+  unsigned int max_burst;      /**< longest run of pushes without draining         */
+  unsigned int overrun_delta;  /**< overruns since previous call to update()       */
+
+  template<typename fifo_type>
+  void update(fifo_type const & fifo) {
+    unsigned int last_overrun = overrun;
+    fifo.get_statistics(*this);
+    overrun_delta = overrun - last_overrun;
+  }
+
+};
+
+
+/**
+ * Ring buffer, keeping track of usage statistics (see fifo_statistics).
+ *
+ * All counters are either producer-owned or consumer-owned (see
+ * fifo_counter), and thus are safe to be updated from an ISR on one
+ * side while being read on the other side.
+ *
+ * All producer paths are accounted: push(), pushs(),
+ * prepare_write() / commit_write() and commit_write_index(). On the
+ * consumer side, underrun counts pop() calls on an empty fifo only
+ * (peek(), read_region() and consume() have no counters).
+ */
 template< typename Tp, unsigned int size >
 class counted_ring_buffer
 : public ring_buffer< Tp, size >
 {
-  unsigned int total;
-  unsigned int overrun;
-  unsigned int underrun;
+  /* producer-owned */
+  fifo_counter total;
+  fifo_counter overrun;
+  fifo_counter peak;
+  fifo_counter burst;
+  fifo_counter max_burst;
+
+  /* consumer-owned */
+  fifo_counter underrun;
 
   using base_type = ring_buffer< Tp, size >;
 
+  /** producer only: account n elements which were pushed onto a fifo of given level (before push) */
+  void account_push(unsigned int level, unsigned int n) {
+    total.add(n);
+    peak.update_max(level + n);
+    if(level == 0)
+      burst.set(n);  /* consumer has drained the fifo, start a new burst */
+    else
+      burst.add(n);
+    max_burst.update_max(burst.get());
+  }
+
 public:
 #if 0 // no constructor. read "why constructors suck for static member variables of template classes" (TODO)
   counted_ring_buffer() : ring_buffer<Tp, size>(), overrun(0), underrun(0) {}
 #endif
 
+  /**
+   * NOTE: This function is not thread-safe. Make sure to call it
+   * while no consumer/producer is accessing the fifo!
+   */
   void reset_counter(void) {
-    total = 0;
-    overrun = 0;
-    underrun = 0;
+    total.reset();
+    overrun.reset();
+    peak.reset();
+    burst.reset();
+    max_burst.reset();
+    underrun.reset();
   };
 
   void reset(void) {
@@ -197,25 +481,194 @@ public:
   }
 
   bool push(Tp c) {
+    unsigned int level = base_type::read_available();
     if(base_type::push(c) == false) {
-      overrun++;
+      overrun.add(1);
       return false;
     }
-    total++;
+    account_push(level, 1);
     return true;
   }
 
+  bool pushs(const Tp * data) {
+    unsigned int level = base_type::read_available();
+    unsigned int count = 0;
+    while(data[count])
+      count++;
+    if(base_type::pushs(data, count) == false) {
+      overrun.add(count);
+      return false;
+    }
+    account_push(level, count);
+    return true;
+  }
+
+  bool pushs(const Tp * data, unsigned int count) {
+    unsigned int level = base_type::read_available();
+    if(base_type::pushs(data, count) == false) {
+      overrun.add(count);
+      return false;
+    }
+    account_push(level, count);
+    return true;
+  }
+
+  /** Counts an overrun if the fifo is full (returns nullptr). */
+  Tp * prepare_write(void) {
+    Tp * slot = base_type::prepare_write();
+    if(slot == nullptr)
+      overrun.add(1);
+    return slot;
+  }
+
+  void commit_write(void) {
+    unsigned int level = base_type::read_available();
+    base_type::commit_write();
+    account_push(level, 1);
+  }
+
+  /** Counts the elements lost on overrun (see ring_buffer::commit_write_index()). */
+  unsigned int commit_write_index(unsigned int index, unsigned int count) {
+    unsigned int level = base_type::read_available();
+    unsigned int lost = base_type::commit_write_index(index, count);
+    if(lost) {
+      overrun.add(lost);
+      level = (size - 1) - (count - lost);  /* fifo is full after overrun */
+    }
+    account_push(level, count - lost);
+    return lost;
+  }
+
   bool pop(Tp &c) {
     if(base_type::pop(c) == false) {
-      underrun++;
+      underrun.add(1);
       return false;
     }
     return true;
   }
 
-  unsigned int get_total(void) { return total; }
-  unsigned int get_overrun(void) { return overrun; }
-  unsigned int get_underrun(void) { return underrun; }
+  unsigned int get_total(void) const { return total.get(); }
+  unsigned int get_overrun(void) const { return overrun.get(); }
+  unsigned int get_underrun(void) const { return underrun.get(); }
+  unsigned int get_peak(void) const { return peak.get(); }
+  unsigned int get_max_burst(void) const { return max_burst.get(); }
+
+  /** Fill a fifo_statistics snapshot (see fifo_statistics::update()) */
+  void get_statistics(fifo_statistics & stat) const {
+    stat.size      = size - 1;
+    stat.level     = base_type::read_available();
+    stat.total     = total.get();
+    stat.overrun   = overrun.get();
+    stat.underrun  = underrun.get();
+    stat.peak      = peak.get();
+    stat.max_burst = max_burst.get();
+  }
+};
+
+
+/**
+ * Fifo with RTS flow control, driven by the fifo level (e.g. as
+ * rx_fifo of usart_irq_stream<>).
+ *
+ * The producer deasserts RTS (rts_type::disable()) as soon as the
+ * fifo level reaches high_watermark, the consumer asserts RTS
+ * (rts_type::enable()) again as soon as the level drops to
+ * low_watermark.
+ *
+ * rts_type is usually a gpio_output<> (with active_state = low for a
+ * nRTS line), make sure to add rts_type::resources to your resource
+ * list.
+ *
+ * NOTE: Choose high_watermark low enough to leave room for the bytes
+ * the remote transmitter sends before it reacts on RTS (e.g. the
+ * size of its hardware fifo).
+ *
+ * NOTE: As rx_fifo of a circular DMA reception (commit_write_index()),
+ * the level is only checked when the DMA data is published (e.g. on
+ * half transfer, transfer complete and IDLE line), while up to half
+ * of the buffer storage might be written but not yet published. This
+ * requires high_watermark + buffer_size / 2 < buffer_size (asserted),
+ * in addition to the room left for the remote transmitter.
+ *
+ * NOTE: The consumer re-checks the level after asserting RTS, and
+ * deasserts it again if the producer has preempted it and filled the
+ * fifo up to high_watermark in the meantime.
+ */
+template< typename fifo_type, typename rts_type, unsigned int high_watermark, unsigned int low_watermark >
+class flow_controlled_fifo
+: public fifo_type
+{
+  static_assert(low_watermark < high_watermark, "low_watermark must be less than high_watermark");
+  static_assert(high_watermark < fifo_type::buffer_size, "high_watermark exceeds fifo capacity");
+
+  /** producer only */
+  void check_high_watermark(void) {
+    if(fifo_type::read_available() >= high_watermark)
+      rts_type::disable();
+  }
+
+  /** consumer only */
+  void check_low_watermark(void) {
+    if(fifo_type::read_available() <= low_watermark) {
+      rts_type::enable();
+      check_high_watermark();  /* producer might have preempted us */
+    }
+  }
+
+public:
+
+  using char_type = typename fifo_type::char_type;
+
+  /**
+   * NOTE: This function is not thread-safe. Make sure to call it
+   * while no consumer/producer is accessing the fifo!
+   */
+  void reset(void) {
+    fifo_type::reset();
+    rts_type::enable();
+  }
+
+  bool push(char_type c) {
+    bool ret = fifo_type::push(c);
+    check_high_watermark();
+    return ret;
+  }
+
+  bool pushs(const char_type * data) {
+    bool ret = fifo_type::pushs(data);
+    check_high_watermark();
+    return ret;
+  }
+
+  bool pushs(const char_type * data, unsigned int count) {
+    bool ret = fifo_type::pushs(data, count);
+    check_high_watermark();
+    return ret;
+  }
+
+  unsigned int commit_write_index(unsigned int index, unsigned int count) {
+    static_assert(high_watermark + fifo_type::buffer_size / 2 < fifo_type::buffer_size,
+                  "high_watermark leaves no room for half a buffer of unpublished DMA data");
+    unsigned int ret = fifo_type::commit_write_index(index, count);
+    check_high_watermark();
+    return ret;
+  }
+
+  bool pop(char_type &c) {
+    bool ret = fifo_type::pop(c);
+    check_low_watermark();
+    return ret;
+  }
+
+  void consume(unsigned int n = 1) {
+    fifo_type::consume(n);
+    check_low_watermark();
+  }
+
+  /** true if RTS is asserted (remote transmitter is allowed to send) */
+  bool rts_active(void) const {
+    return rts_type::active();
+  }
 };
 
 } // namespace mptl
@@ -0,0 +1,120 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MESSAGE_QUEUE_HPP_INCLUDED
+#define MESSAGE_QUEUE_HPP_INCLUDED
+
+#include <fifo.hpp>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+namespace mptl {
+
+/**
+ * Lockfree queue of fixed-size message records (single reader, single
+ * writer), e.g. for posting events from an ISR to the main loop.
+ *
+ * Messages are copied (or constructed) directly into the ring_buffer
+ * slot, and published to the consumer by a single release store of
+ * the write index: the consumer never sees a partially written
+ * message.
+ *
+ * NOTE: capacity is the number of messages which can be queued
+ * (unlike ring_buffer, where one slot is always kept free).
+ *
+ * The ring_buffer is inherited privately: messages are only accessed
+ * using post(), emplace() and drain(). Derived queues (e.g.
+ * deferred_log<>) have access to the slot-level primitives.
+ */
+template< typename Tp, unsigned int capacity >
+class message_queue
+: private ring_buffer< Tp, capacity + 1 >
+{
+  static_assert(std::is_trivially_copyable<Tp>::value, "message type must be trivially copyable");
+
+  using base_type = ring_buffer< Tp, capacity + 1 >;
+
+protected:
+
+  using base_type::prepare_write;
+  using base_type::commit_write;
+
+public:
+
+  using message_type = Tp;
+
+  using base_type::reset;
+  using base_type::read_available;
+  using base_type::write_available;
+
+  /**
+   * Producer only: copy msg into the queue.
+   * Returns false (and discards msg) if the queue is full.
+   */
+  bool post(Tp const & msg) {
+    Tp * slot = base_type::prepare_write();
+    if(slot == nullptr)
+      return false;
+    *slot = msg;
+    base_type::commit_write();
+    return true;
+  }
+
+  /**
+   * Producer only: construct a message in place, using brace
+   * initialization (works for aggregates as well as for types with
+   * constructors).
+   * Returns false if the queue is full.
+   */
+  template< typename... Args >
+  bool emplace(Args&&... args) {
+    Tp * slot = base_type::prepare_write();
+    if(slot == nullptr)
+      return false;
+    ::new(static_cast<void *>(slot)) Tp{ std::forward<Args>(args)... };
+    base_type::commit_write();
+    return true;
+  }
+
+  /**
+   * Consumer only: call func(Tp const &) for up to max_count queued
+   * messages. The slots are handed back to the producer all at once
+   * after the batch is processed.
+   *
+   * Returns the number of messages processed.
+   */
+  template< typename F >
+  unsigned int drain(F && func, unsigned int max_count = capacity) {
+    unsigned int n = 0;
+    Tp * msg;
+    while((n < max_count) && ((msg = base_type::peek(n)) != nullptr)) {
+      func(static_cast<Tp const &>(*msg));
+      n++;
+    }
+    if(n)
+      base_type::consume(n);
+    return n;
+  }
+};
+
+} // namespace mptl
+
+#endif // MESSAGE_QUEUE_HPP_INCLUDED
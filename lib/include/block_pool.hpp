@@ -0,0 +1,228 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BLOCK_POOL_HPP_INCLUDED
+#define BLOCK_POOL_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdlib>
+
+namespace mptl {
+
+/** Snapshot of block_pool usage (see block_pool::get_statistics()) */
+struct block_pool_statistics
+{
+  unsigned int size;     /**< number of blocks in pool                  */
+  unsigned int used;     /**< number of allocated blocks                */
+  unsigned int peak;     /**< high-water mark of allocated blocks       */
+  unsigned int total;    /**< number of successful allocations          */
+  unsigned int failed;   /**< number of failed allocations (exhausted)  */
+};
+
+
+/**
+ * Fixed-block memory pool: static storage for blocks (compile-time
+ * sized), O(1) allocate() and deallocate().
+ *
+ * Released blocks are kept in a singly linked free list (the link
+ * is stored in the free block itself). Blocks which were never
+ * allocated are handed out in order, which makes the pool valid
+ * without initialization of the storage (a static block_pool lives
+ * in .bss, and is usable before constructors are called).
+ *
+ * NOTE: not thread-safe: if used from ISR context, protect all calls
+ * by a critical_section.
+ */
+template<
+  std::size_t  _block_size,
+  unsigned int _blocks,
+  std::size_t  alignment = alignof(std::max_align_t)
+  >
+class block_pool
+{
+  static_assert(_block_size > 0, "block_size must be greater than zero");
+  static_assert(_blocks > 0, "pool must contain at least one block");
+  static_assert((alignment & (alignment - 1)) == 0, "alignment must be a power of two");
+
+  union block {
+    block * next;
+    alignas(alignment) unsigned char data[_block_size];
+  };
+
+  block storage[_blocks];
+  block * free_list;     /* released blocks */
+  unsigned int fresh;    /* blocks [fresh, _blocks) were never allocated */
+
+  unsigned int used;
+  unsigned int peak;
+  unsigned int total;
+  unsigned int failed;
+
+public:
+
+  static constexpr std::size_t  block_size      = sizeof(block);   /**< effective size (incl. alignment) */
+  static constexpr std::size_t  block_alignment = alignof(block);
+  static constexpr unsigned int capacity        = _blocks;
+
+  constexpr block_pool(void)
+  : storage(), free_list(nullptr), fresh(0), used(0), peak(0), total(0), failed(0)
+  { }
+
+  block_pool(block_pool const &) = delete;
+  block_pool & operator=(block_pool const &) = delete;
+
+  /**
+   * Allocate a block of (at least) _block_size bytes.
+   * Returns nullptr if the pool is exhausted.
+   */
+  void * allocate(void) {
+    block * b = free_list;
+    if(b) {
+      free_list = b->next;
+    }
+    else if(fresh < _blocks) {
+      b = &storage[fresh++];
+    }
+    else {
+      failed++;
+      return nullptr;
+    }
+    used++;
+    total++;
+    if(used > peak)
+      peak = used;
+    return b->data;
+  }
+
+  /** Release a block, previously returned by allocate(). Ignores nullptr. */
+  void deallocate(void * p) {
+    if(p == nullptr)
+      return;
+    block * b = static_cast<block *>(p);
+    b->next = free_list;
+    free_list = b;
+    used--;
+  }
+
+  /** true if p points into the storage of this pool */
+  bool owns(const void * p) const {
+    const unsigned char * c = static_cast<const unsigned char *>(p);
+    const unsigned char * begin = storage[0].data;
+    return (c >= begin) && (c < begin + sizeof(storage));
+  }
+
+  /** number of blocks available for allocation */
+  unsigned int available(void) const {
+    return _blocks - used;
+  }
+
+  /** Fill a block_pool_statistics snapshot */
+  void get_statistics(block_pool_statistics & stat) const {
+    stat.size   = _blocks;
+    stat.used   = used;
+    stat.peak   = peak;
+    stat.total  = total;
+    stat.failed = failed;
+  }
+
+  /** Reset the counters (peak is set to the current number of allocated blocks) */
+  void reset_counter(void) {
+    peak = used;
+    total = failed = 0;
+  }
+};
+
+
+/** Default exhaustion handler of pool_allocator: calls std::abort() */
+struct pool_exhausted_abort
+{
+  static void exhausted(void) { std::abort(); }
+};
+
+
+/**
+ * STL-compatible allocator, allocating single objects from a
+ * block_pool (pointer passed as template argument).
+ *
+ * Suitable for node based containers (std::list, std::set, std::map):
+ * the container rebinds the allocator to its node type, which must
+ * fit into a block (asserted). Allocations of more than one object
+ * (e.g. std::vector) fail.
+ *
+ * If the pool is exhausted, exhausted_handler::exhausted() is called.
+ * STL containers do not handle allocation failures without
+ * exceptions: the handler must not return when used with a
+ * container (the default handler calls std::abort()).
+ *
+ * Example:
+ *
+ *     using item_pool = mptl::block_pool< 4 * sizeof(void *), 16 >;
+ *     item_pool pool;
+ *     using item_list = std::list< Item *, mptl::pool_allocator< Item *, item_pool, &pool > >;
+ */
+template<
+  typename Tp,
+  typename pool_type,
+  pool_type * pool,
+  typename exhausted_handler = pool_exhausted_abort
+  >
+class pool_allocator
+{
+public:
+
+  using value_type = Tp;
+
+  template< typename U >
+  struct rebind {
+    using other = pool_allocator< U, pool_type, pool, exhausted_handler >;
+  };
+
+  constexpr pool_allocator(void) { }
+
+  template< typename U >
+  constexpr pool_allocator(pool_allocator< U, pool_type, pool, exhausted_handler > const &) { }
+
+  Tp * allocate(std::size_t n) {
+    static_assert(sizeof(Tp) <= pool_type::block_size, "object does not fit into block_pool block_size");
+    static_assert(pool_type::block_alignment % alignof(Tp) == 0, "object alignment exceeds block_pool alignment");
+    void * p = (n == 1) ? pool->allocate() : nullptr;
+    if(p == nullptr)
+      exhausted_handler::exhausted();
+    return static_cast<Tp *>(p);
+  }
+
+  void deallocate(Tp * p, std::size_t) {
+    pool->deallocate(p);
+  }
+};
+
+template< typename T, typename U, typename pool_type, pool_type * pool, typename exhausted_handler >
+constexpr bool operator==(pool_allocator< T, pool_type, pool, exhausted_handler > const &, pool_allocator< U, pool_type, pool, exhausted_handler > const &) {
+  return true;
+}
+
+template< typename T, typename U, typename pool_type, pool_type * pool, typename exhausted_handler >
+constexpr bool operator!=(pool_allocator< T, pool_type, pool, exhausted_handler > const &, pool_allocator< U, pool_type, pool, exhausted_handler > const &) {
+  return false;
+}
+
+} // namespace mptl
+
+#endif // BLOCK_POOL_HPP_INCLUDED
@@ -0,0 +1,244 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEFERRED_LOG_HPP_INCLUDED
+#define DEFERRED_LOG_HPP_INCLUDED
+
+#include <message_queue.hpp>
+#include <poorman_ostream.hpp>
+#include <cstdint>
+
+/**
+ * Section holding the format strings of MPTL_LOG() call sites.
+ *
+ * On target, the linker script places this section at address 0 and
+ * does not load it (INFO): the format strings cost no flash, and the
+ * address of a format string (its offset in the section) is used as
+ * string id. Use bin/log_decode.pl to decode deferred_log::dump()
+ * output on the host.
+ *
+ * In simulation, the section is loaded and can be read directly (see
+ * deferred_log::print()).
+ */
+#define MPTL_LOG_SECTION  ".mptl_log"
+
+/**
+ * Log a message to deferred_log "log":
+ *
+ *     MPTL_LOG(Kernel::trace, "joystick: pos=%u button=%u", pos, button);
+ *
+ * Only the string id and the raw argument words are queued, the
+ * formatting is done later (host-side, or by deferred_log::print()).
+ *
+ * Supported format specifiers: %u, %d, %x, %c, %%, with optional
+ * '0' flag and width (e.g. "%08x").
+ *
+ * NOTE: do not use in inline functions or templates defined in
+ * headers (the static format string would end up in a COMDAT group,
+ * conflicting with the section attribute).
+ */
+#define MPTL_LOG(log, fmt, ...)                                         \
+  do {                                                                  \
+    static const char mptl_log_fmt[]                                    \
+      __attribute__((section(MPTL_LOG_SECTION), used)) = fmt;           \
+    (log).write(mptl_log_fmt, ##__VA_ARGS__);                           \
+  } while(0)
+
+
+namespace mptl {
+
+template< unsigned int max_args >
+struct deferred_log_record {
+  const char * fmt;
+  uint32_t arg[max_args];
+};
+
+/**
+ * Deferred (binary) logging facility.
+ *
+ * Queues log records of format string id and up to max_args raw
+ * argument words (see MPTL_LOG()) into a message_queue. Arguments
+ * must be integral or enum types of at most 32 bits (asserted).
+ *
+ * NOTE: Lockfree single producer, single consumer: use one
+ * deferred_log per producing context (e.g. one for the main loop,
+ * one per ISR).
+ */
+template< unsigned int capacity, unsigned int _max_args = 3 >
+class deferred_log
+: public message_queue< deferred_log_record<_max_args>, capacity >
+{
+  using base_type = message_queue< deferred_log_record<_max_args>, capacity >;
+
+  unsigned int dropped_count;  /* producer-owned */
+
+  static void store_args(uint32_t *) { }
+
+  template< typename T, typename... Args >
+  static void store_args(uint32_t * dst, T arg, Args... args) {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "deferred_log arguments must be integral or enum types");
+    static_assert(sizeof(T) <= sizeof(uint32_t), "deferred_log arguments must fit into 32 bits");
+    *dst = static_cast<uint32_t>(arg);
+    store_args(dst + 1, args...);
+  }
+
+public:
+
+  static constexpr unsigned int max_args = _max_args;
+  using record_type = deferred_log_record<max_args>;
+
+  /** Size of a record in dump() output (in bytes) */
+  static constexpr unsigned int dump_record_size = 4 + 4 * max_args;
+
+  /**
+   * NOTE: This function is not thread-safe. Make sure to call it
+   * while no consumer/producer is accessing the log!
+   */
+  void reset(void) {
+    base_type::reset();
+    dropped_count = 0;
+  }
+
+  /**
+   * Producer only: queue log record (use MPTL_LOG() instead of
+   * calling this directly).
+   * Returns false (and counts a dropped record) if the log is full.
+   */
+  template< typename... Args >
+  bool write(const char * fmt, Args... args) {
+    static_assert(sizeof...(Args) <= max_args, "too many arguments for deferred_log");
+    record_type * rec = base_type::prepare_write();
+    if(rec == nullptr) {
+      dropped_count++;
+      return false;
+    }
+    rec->fmt = fmt;
+    store_args(rec->arg, args...);
+    for(unsigned int i = sizeof...(Args); i < max_args; i++)
+      rec->arg[i] = 0;  /* no stale data in dump() */
+    base_type::commit_write();
+    return true;
+  }
+
+  /** Number of records dropped (log full) */
+  unsigned int dropped(void) const {
+    return dropped_count;
+  }
+
+  /**
+   * Consumer only: write up to max_count records in binary form to
+   * out, for decoding on the host (see bin/log_decode.pl):
+   *
+   *     <id:u32> <arg:u32> * max_args   (little-endian)
+   *
+   * Returns the number of records written.
+   */
+  template< typename stream_type >
+  unsigned int dump(stream_type & out, unsigned int max_count = capacity) {
+    return base_type::drain([&](record_type const & rec) {
+        uint32_t id = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(rec.fmt));
+        out.write(reinterpret_cast<const char *>(&id), 4);
+        out.write(reinterpret_cast<const char *>(rec.arg), 4 * max_args);
+      }, max_count);
+  }
+
+  /**
+   * Expand format string of rec to out.
+   *
+   * NOTE: The format strings are only accessible if MPTL_LOG_SECTION
+   * is loaded (e.g. in simulation).
+   */
+  template< typename stream_type >
+  static void format(stream_type & out, record_type const & rec) {
+    const char * p = rec.fmt;
+    unsigned int n = 0;
+
+    while(*p) {
+      const char * s = p;
+      while(*p && (*p != '%'))
+        p++;
+      if(p != s)
+        out.write(s, p - s);
+      if(*p == 0)
+        break;
+
+      p++;  /* skip '%' */
+      char fill = ' ';
+      unsigned int width = 0;
+      if(*p == '0') {
+        fill = '0';
+        p++;
+      }
+      while((*p >= '0') && (*p <= '9'))
+        width = width * 10 + (*p++ - '0');
+
+      if(*p == '%') {
+        out.put('%');
+        p++;
+        continue;
+      }
+      uint32_t val = n < max_args ? rec.arg[n++] : 0;
+      switch(*p) {
+      case 'u':
+        out << poorman::dec << poorman::setfill(fill) << poorman::setw(width) << val;
+        break;
+      case 'd':
+        out << poorman::dec << poorman::setfill(fill) << poorman::setw(width) << static_cast<int32_t>(val);
+        break;
+      case 'x':
+        out << poorman::hex << poorman::setfill(fill) << poorman::setw(width ? width : 1) << val;
+        break;
+      case 'c':
+        out.put(static_cast<char>(val));
+        break;
+      case 0:
+        continue;
+      default:
+        out.put('?');
+      }
+      p++;
+    }
+    out << poorman::hex << poorman::setfill(' ');
+  }
+
+#ifdef OPENMPTL_SIMULATION
+  /**
+   * Consumer only: print up to max_count records (one per line) to
+   * out. Returns the number of records printed.
+   */
+  template< typename stream_type >
+  unsigned int print(stream_type & out, unsigned int max_count = capacity) {
+    return base_type::drain([&](record_type const & rec) {
+        format(out, rec);
+        out << poorman::endl;
+      }, max_count);
+  }
+#endif // OPENMPTL_SIMULATION
+};
+
+template< unsigned int capacity, unsigned int _max_args >
+constexpr unsigned int deferred_log<capacity, _max_args>::max_args;
+
+template< unsigned int capacity, unsigned int _max_args >
+constexpr unsigned int deferred_log<capacity, _max_args>::dump_record_size;
+
+} // namespace mptl
+
+#endif // DEFERRED_LOG_HPP_INCLUDED
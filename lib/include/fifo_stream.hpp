@@ -25,9 +25,15 @@
 
 namespace mptl {
 
+/**
+ * Output stream on fifo, flushing to deviceT.
+ *
+ * Derives from poorman::static_ostream<> (non-virtual): use
+ * poorman::ostream_adapter<> if a poorman::ostream<> is needed.
+ */
 template<typename fifoT, typename deviceT>
 class fifo_stream
-: public poorman::ostream<typename fifoT::char_type>
+: public poorman::static_ostream< fifo_stream<fifoT, deviceT>, typename fifoT::char_type >
 {
   fifoT & fifo;
 
@@ -37,27 +43,27 @@ public:
 
   using char_type = typename fifoT::char_type;
 
-  poorman::ostream<char_type> & put(char_type c) {
+  fifo_stream & put(char_type c) {
     fifo.push(c);
     return *this;
   }
 
-  poorman::ostream<char_type> & write(const char_type* s, unsigned int count) {
+  fifo_stream & write(const char_type* s, unsigned int count) {
     fifo.pushs(s, count);
     return *this;
   }
 
-  poorman::ostream<char_type> & puts(const char_type* s) {
+  fifo_stream & puts(const char_type* s) {
     fifo.pushs(s);
     return *this;
   }
 
-  poorman::ostream<char_type> & flush() {
+  fifo_stream & flush() {
     deviceT::flush();
     return *this;
   }
 
-  poorman::ostream<char_type> & endl() {
+  fifo_stream & endl() {
     if(deviceT::crlf)
       fifo.push('\r');
     fifo.push('\n');
@@ -0,0 +1,188 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ISR_TRACE_HPP_INCLUDED
+#define ISR_TRACE_HPP_INCLUDED
+
+#include <profiler.hpp>
+#include <arch/nvic.hpp>
+#include <poorman_ostream.hpp>
+#include <cstdint>
+
+namespace mptl {
+
+/** Statistics of an interrupt service routine */
+struct isr_stats
+{
+  profile_stats duration;   /**< time spent in isr (entry to exit) */
+  uint32_t last_entry;
+  uint32_t interval_min;    /**< min time between two isr entries */
+  uint32_t interval_max;    /**< max time between two isr entries */
+  uint32_t overruns;        /**< number of calls exceeding the budget */
+
+  void reset(void) {
+    duration.reset();
+    last_entry = interval_min = interval_max = overruns = 0;
+  }
+
+  void enter(uint32_t now) {
+    if(duration.count) {
+      uint32_t interval = now - last_entry;  /* wrap-around safe */
+      if((duration.count == 1) || (interval < interval_min))
+        interval_min = interval;
+      if(interval > interval_max)
+        interval_max = interval;
+    }
+    last_entry = now;
+  }
+
+  void leave(uint32_t elapsed, uint32_t budget) {
+    duration.add(elapsed, elapsed);
+    if(budget && (elapsed > budget))
+      overruns++;
+  }
+
+  /** jitter of the isr entry (min/max deviation of entry interval) */
+  uint32_t jitter(void) const {
+    return interval_max - interval_min;
+  }
+};
+
+
+namespace mpl {
+
+template< typename isr_trace_type >
+struct isr_trace_impl
+{
+  template< typename... Tp >
+  struct pack {
+    using type = pack;
+
+    static void reset(void) {
+      int expand[] = { 0, (isr_trace_type::template stats< typename Tp::irq_type >().reset(), 0)... };
+      (void)expand;
+    }
+
+    static void dump(poorman::ostream<char> & cout, const char * unit) {
+      int expand[] = { 0, (dump_irq< typename Tp::irq_type >(cout, unit), 0)... };
+      (void)expand;
+    }
+
+    template< typename irq_type >
+    static void dump_irq(poorman::ostream<char> & cout, const char * unit) {
+      if(irq_type::irqn != irq::reset::irqn)  /* never wrapped */
+        isr_trace_type::dump_irq(cout, irq_type::irqn, isr_trace_type::template stats< irq_type >(), unit);
+    }
+  };
+};
+
+} // namespace mpl
+
+
+/**
+ * ISR tracing: wraps interrupt service routines with a trampoline
+ * recording entry/exit timestamps into per-irq statistics.
+ *
+ * Passed as isr_wrapper template argument to mptl::vector_table<>,
+ * which replaces the isr of every irq_handler<> in the resources list
+ * by isr_trace::wrap<>::isr (except the reset handler). If not
+ * passed, the vector table holds the plain isr's (no overhead).
+ *
+ * Example:
+ *
+ *     using isr_trace = mptl::isr_trace< mptl::profiler_clock, sysclk::hclk_freq / 100000 >;
+ *     using vector_table = mptl::vector_table< &_stack_top, resources, error_isr, isr_trace >;
+ *
+ *     isr_trace::stats< systick::irq >().duration.max;
+ *     isr_trace::dump< resources >(cout);
+ *
+ * Template arguments:
+ *
+ *   - clock_type: time source providing "uint32_t now()", see
+ *        mptl::profiler_clock (DWT cycle counter, needs to be
+ *        enabled before use).
+ *
+ *   - budget: count isr calls taking longer than budget (in units
+ *        of clock_type, 0: disabled).
+ *
+ * NOTE: durations are inclusive: the time spent in preempting
+ * (higher priority) isr's is accounted to the preempted isr.
+ */
+template< typename clock_type = profiler_clock, uint32_t budget = 0 >
+struct isr_trace
+{
+  using type = isr_trace< clock_type, budget >;
+
+  template< typename irq_type >
+  struct irq {
+    static isr_stats stats;
+  };
+
+  /** Provides the trampoline calling irq_handler_type::value() */
+  template< typename irq_handler_type >
+  struct wrap {
+    static void isr(void) {
+      isr_stats & st = irq< typename irq_handler_type::irq_type >::stats;
+      uint32_t start = clock_type::now();
+      st.enter(start);
+      irq_handler_type::value();
+      st.leave(clock_type::now() - start, budget);
+    }
+  };
+
+  template< typename irq_type >
+  static isr_stats & stats(void) {
+    return irq< irq_type >::stats;
+  }
+
+  /** Reset statistics of all irq_handler<> in resources typelist */
+  template< typename resources >
+  static void reset(void) {
+    mpl::irq_handler_list< resources >::template pack< mpl::isr_trace_impl< type > >::type::reset();
+  }
+
+  /** Print statistics of all irq_handler<> in resources typelist */
+  template< typename resources >
+  static void dump(poorman::ostream<char> & cout, const char * unit = profiler_clock::unit) {
+    cout << poorman::dec;
+    mpl::irq_handler_list< resources >::template pack< mpl::isr_trace_impl< type > >::type::dump(cout, unit);
+    cout << poorman::hex;
+  }
+
+  static void dump_irq(poorman::ostream<char> & cout, int irqn, isr_stats const & st, const char * unit) {
+    cout << "irq " << irqn
+         << ": n=" << st.duration.count
+         << " min=" << st.duration.min
+         << " mean=" << st.duration.mean()
+         << " max=" << st.duration.max
+         << " jitter=" << st.jitter();
+    if(budget)
+      cout << " over=" << st.overruns;
+    cout << " [" << unit << "]" << poorman::endl;
+  }
+};
+
+template< typename clock_type, uint32_t budget >
+template< typename irq_type >
+isr_stats isr_trace< clock_type, budget >::irq< irq_type >::stats;
+
+} // namespace mptl
+
+#endif // ISR_TRACE_HPP_INCLUDED
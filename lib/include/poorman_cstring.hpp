@@ -22,6 +22,7 @@
 #define POORMAN_CSTRING_HPP_INCLUDED
 
 #include <type_traits>
+#include <limits>
 
 namespace poorman {
 
@@ -89,6 +90,153 @@ itoa(char * buf, Tp value, int n, char padding = '0') {
   itoa(buf, (unsigned)(-value), n-1, padding);
 }
 
+/** Table of decimal digit pairs "00" .. "99" */
+template<typename Tp = void>
+struct digit_pairs {
+  static constexpr char value[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+};
+template<typename Tp> constexpr char digit_pairs<Tp>::value[];
+
+/**
+ * Prints decimal digits of unsigned "value" backwards to buffer
+ * ending at buf_end (not zero terminated), using a digit-pair table
+ * (one division per two digits).
+ *
+ * Returns pointer to the first (most significant) digit.
+ *
+ * NOTE: buffer must hold at least std::numeric_limits<Tp>::digits10 + 1 characters
+ */
+template<typename Tp>
+char * utoa_rev(char * buf_end, Tp value) {
+  static_assert(std::is_unsigned<Tp>::value, "Tp must be unsigned");
+  const char * pairs = digit_pairs<>::value;
+  while(value >= 100) {
+    unsigned i = (unsigned)(value % 100) * 2;
+    value /= 100;
+    *--buf_end = pairs[i + 1];
+    *--buf_end = pairs[i];
+  }
+  if(value >= 10) {
+    unsigned i = (unsigned)value * 2;
+    *--buf_end = pairs[i + 1];
+    *--buf_end = pairs[i];
+  }
+  else {
+    *--buf_end = '0' + (char)value;
+  }
+  return buf_end;
+}
+
+/**
+ * Prints hexadecimal digits of unsigned "value" backwards to buffer
+ * ending at buf_end (not zero terminated), '0'-padded to at least
+ * min_digits.
+ *
+ * Returns pointer to the first (most significant) digit.
+ *
+ * NOTE: buffer must hold at least max(sizeof(Tp) * 2, min_digits) characters
+ */
+template<typename Tp>
+char * utoa_hex_rev(char * buf_end, Tp value, unsigned min_digits = 1) {
+  static_assert(std::is_unsigned<Tp>::value, "Tp must be unsigned");
+  unsigned v;
+  do {
+    v = value & 0xf;
+    *--buf_end = v < 10 ? '0' + v : 'a' + v - 10;
+    value >>= 4;
+    if(min_digits)
+      min_digits--;
+  } while(value || min_digits);
+  return buf_end;
+}
+
+/**
+ * Parses hexadecimal number from zero terminated string s (with
+ * optional "0x" prefix) into "value".
+ *
+ * Returns false (leaving "value" untouched) if s is empty, contains
+ * non-hexadecimal characters, or does not fit into Tp.
+ */
+template<typename Tp>
+bool atoi_hex(const char * s, Tp & value) {
+  using value_type = typename std::make_unsigned<Tp>::type;
+  value_type val = 0;
+  unsigned v;
+
+  if((s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X')))
+    s += 2;
+  if(*s == 0)
+    return false;
+
+  for(; *s; s++) {
+    if((*s >= '0') && (*s <= '9'))      v = *s - '0';
+    else if((*s >= 'a') && (*s <= 'f')) v = *s - 'a' + 10;
+    else if((*s >= 'A') && (*s <= 'F')) v = *s - 'A' + 10;
+    else
+      return false;
+    if(val >> (sizeof(value_type) * 8 - 4))
+      return false;  /* overflow */
+    val = (val << 4) | v;
+  }
+  value = (Tp)val;
+  return true;
+}
+
+/**
+ * Parses decimal number from zero terminated string s into "value".
+ * Numbers prefixed with "0x" are parsed as hexadecimal (see
+ * atoi_hex()), a leading '-' is accepted for signed types.
+ *
+ * Returns false (leaving "value" untouched) if s is not a valid
+ * number, or does not fit into Tp.
+ */
+template<typename Tp>
+bool atoi(const char * s, Tp & value) {
+  using value_type = typename std::make_unsigned<Tp>::type;
+  constexpr value_type max = std::numeric_limits<Tp>::max();
+  value_type val = 0;
+  bool negative = false;
+
+  if(std::is_signed<Tp>::value && (*s == '-')) {
+    negative = true;
+    s++;
+  }
+
+  if((s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X'))) {
+    if(!atoi_hex(s, val))
+      return false;
+  }
+  else {
+    if(*s == 0)
+      return false;
+    for(; *s; s++) {
+      if((*s < '0') || (*s > '9'))
+        return false;
+      unsigned v = *s - '0';
+      if(val > (value_type)(std::numeric_limits<value_type>::max() - v) / 10)
+        return false;  /* overflow */
+      val = val * 10 + v;
+    }
+  }
+
+  /* allow one more for negative numbers (two's complement) */
+  if(val > max + (negative ? 1 : 0))
+    return false;
+
+  value = negative ? (Tp)(0 - val) : (Tp)val;
+  return true;
+}
+
 } // namespace poorman
 
 #endif // POORMAN_CSTRING_HPP_INCLUDED
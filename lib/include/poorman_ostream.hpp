@@ -21,18 +21,106 @@
 #ifndef POORMAN_OSTREAM_HPP_INCLUDED
 #define POORMAN_OSTREAM_HPP_INCLUDED
 
+#include <poorman_cstring.hpp>
 #include <type_traits>
 
 namespace poorman {
 
+/** manipulator type, see setw() */
+struct width_manip {
+  unsigned width;
+};
+
+/** manipulator type, see setfill() */
 template<typename Tp>
-class ostream
+struct fill_manip {
+  Tp fill;
+};
+
+/**
+ * Formatting state and integral formatting, shared by ostream<> and
+ * static_ostream<>.
+ */
+template<typename Tp>
+class ostream_format
 {
-  static char nibble(unsigned val) {
-    val &= 0xf;
-    return val < 10 ? '0' + val : 'a' + val - 10;
+  unsigned char fmt_base  = 16;
+  unsigned char fmt_width = 0;
+  Tp            fmt_fill  = ' ';
+
+protected:
+
+  static constexpr unsigned max_width = 32;
+
+  /**
+   * Format integral value backwards into buffer ending at buf_end
+   * (of size max_width), returns pointer to first character:
+   *
+   *   - hex (default): width 0 prints all digits of valT ('0'-padded,
+   *     e.g. "0000002a" for a 32bit value). Negative values are
+   *     printed as two's complement.
+   *   - dec: prints minimal number of digits, with leading '-' for
+   *     negative values.
+   *
+   * If a width is set (setw()), the output is right aligned and padded
+   * with the fill character (setfill(), default: ' '). As with
+   * std::ostream, the width is reset after each output.
+   */
+  template<typename valT>
+  char * format(char * const end, valT val)
+  {
+    using uvalT = typename std::make_unsigned<valT>::type;
+    char * p;
+    unsigned width = fmt_width;
+    bool negative = false;
+
+    if(fmt_base == 10) {
+      negative = std::is_signed<valT>::value && (val < 0);
+      p = utoa_rev(end, negative ? (uvalT)(0 - (uvalT)val) : (uvalT)val);
+    }
+    else {
+      p = utoa_hex_rev(end, (uvalT)val, width ? 1 : sizeof(valT) * 2);
+    }
+
+    if(fmt_fill == '0') {
+      /* sign first, then zero padding: "-0042" */
+      while((unsigned)(end - p) + (negative ? 1 : 0) < width)
+        *--p = '0';
+      if(negative)
+        *--p = '-';
+    }
+    else {
+      if(negative)
+        *--p = '-';
+      while((unsigned)(end - p) < width)
+        *--p = fmt_fill;
+    }
+
+    fmt_width = 0;
+    return p;
   }
 
+public:
+
+  void set_base(unsigned base)     { fmt_base = base; }
+  void set_width(unsigned width)   { fmt_width = width < max_width ? width : (unsigned)max_width; }
+  void set_fill(Tp fill)           { fmt_fill = fill; }
+};
+
+
+/**
+ * Output stream interface (virtual).
+ *
+ * Use this as type-erased stream (e.g. for terminal hooks). For
+ * output in hot paths, prefer static_ostream<>, which does not need
+ * an indirect call per character.
+ */
+template<typename Tp>
+class ostream
+: public ostream_format<Tp>
+{
+  using base_type = ostream_format<Tp>;
+
 public:
   using char_type = Tp;
 
@@ -43,15 +131,15 @@ public:
   virtual ostream & endl() = 0;
   //  virtual ostream & widen(char_type c) { };  // TODO: implement in terminal_ostream
 
-  /** hexadecimal output of any integral type */
+  /** Output of any integral type, see ostream_format::format() */
   template<typename valT>
   typename std::enable_if<std::is_integral<valT>::value, ostream &>::type
   friend operator <<(ostream & st, valT val)
   {
-    for(int i = sizeof(valT) * 8 - 4; i >= 0; i -= 4) {
-      st.put(nibble(val >> i));
-    }
-    return st;
+    char buf[base_type::max_width];
+    char * const end = buf + base_type::max_width;
+    char * p = st.format(end, val);
+    return st.write(p, end - p);
   }
 
   friend ostream & operator<<(ostream & st, const char * s) {
@@ -62,18 +150,164 @@ public:
   ostream& operator<<(ostream& (*func)(ostream&)) {
     return func(*this);
   }
+
+  ostream& operator<<(width_manip m) {
+    this->set_width(m.width);
+    return *this;
+  }
+
+  ostream& operator<<(fill_manip<char_type> m) {
+    this->set_fill(m.fill);
+    return *this;
+  }
+};
+
+
+/**
+ * Static output stream (CRTP).
+ *
+ * Same interface as ostream<>, but calls the (non-virtual) put(),
+ * puts(), write(), flush() and endl() of Derived directly, allowing
+ * the compiler to inline them:
+ *
+ *     class my_stream : public poorman::static_ostream<my_stream, char> {
+ *     public:
+ *       my_stream & put(char c);
+ *       my_stream & puts(const char * s);
+ *       my_stream & write(const char * s, unsigned int count);
+ *       my_stream & flush();
+ *       my_stream & endl();
+ *     };
+ *
+ * Use ostream_adapter<> where a (virtual) ostream<> is needed.
+ */
+template<typename Derived, typename Tp>
+class static_ostream
+: public ostream_format<Tp>
+{
+  using base_type = ostream_format<Tp>;
+
+  Derived & derived() {
+    return static_cast<Derived &>(*this);
+  }
+
+public:
+  using char_type = Tp;
+
+  /** Output of any integral type, see ostream_format::format() */
+  template<typename valT>
+  typename std::enable_if<std::is_integral<valT>::value, Derived &>::type
+  operator<<(valT val)
+  {
+    char buf[base_type::max_width];
+    char * const end = buf + base_type::max_width;
+    char * p = this->format(end, val);
+    return derived().write(p, end - p);
+  }
+
+  Derived & operator<<(const char * s) {
+    return derived().puts(s);
+  }
+
+  Derived & operator<<(Derived & (*func)(Derived &)) {
+    return func(derived());
+  }
+
+  Derived & operator<<(width_manip m) {
+    this->set_width(m.width);
+    return derived();
+  }
+
+  Derived & operator<<(fill_manip<char_type> m) {
+    this->set_fill(m.fill);
+    return derived();
+  }
+};
+
+
+/**
+ * Adapter providing the (virtual) ostream<> interface for a static
+ * stream (e.g. static_ostream<> based fifo_stream<>).
+ *
+ * NOTE: the adapter has its own formatting state (dec/hex/setw/setfill).
+ */
+template<typename stream_type>
+class ostream_adapter
+: public ostream<typename stream_type::char_type>
+{
+  stream_type & st;
+
+public:
+  using char_type = typename stream_type::char_type;
+
+  ostream_adapter(stream_type & s) : st(s) { };
+
+  ostream<char_type> & put(char_type c) {
+    st.put(c);
+    return *this;
+  }
+
+  ostream<char_type> & puts(const char_type* s) {
+    st.puts(s);
+    return *this;
+  }
+
+  ostream<char_type> & write(const char_type* s, unsigned int count) {
+    st.write(s, count);
+    return *this;
+  }
+
+  ostream<char_type> & flush() {
+    st.flush();
+    return *this;
+  }
+
+  ostream<char_type> & endl() {
+    st.endl();
+    return *this;
+  }
 };
 
+
+template<typename Tp> constexpr unsigned ostream_format<Tp>::max_width;
+
 /** manipulator, flushes the output stream */
-template<typename Tp>
-inline ostream<Tp> & flush(ostream<Tp> & st) {
-  return st.flush();
+template<typename stream_type>
+inline stream_type & flush(stream_type & st) {
+  st.flush();
+  return st;
 }
 
 /** manipulator, outputs newline and flushes the output stream */
+template<typename stream_type>
+inline stream_type & endl(stream_type & st) {
+  st.endl();
+  return st;
+}
+
+/** manipulator, decimal output of integral types */
+template<typename stream_type>
+inline stream_type & dec(stream_type & st) {
+  st.set_base(10);
+  return st;
+}
+
+/** manipulator, hexadecimal output of integral types (default) */
+template<typename stream_type>
+inline stream_type & hex(stream_type & st) {
+  st.set_base(16);
+  return st;
+}
+
+/** manipulator, sets field width of next integral output */
+inline width_manip setw(unsigned width) {
+  return width_manip{ width };
+}
+
+/** manipulator, sets fill character for setw() */
 template<typename Tp>
-inline ostream<Tp> & endl(ostream<Tp> & st) {
-  return st.endl();
+inline fill_manip<Tp> setfill(Tp fill) {
+  return fill_manip<Tp>{ fill };
 }
 
 } // namespace poorman
@@ -0,0 +1,243 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PROFILER_HPP_INCLUDED
+#define PROFILER_HPP_INCLUDED
+
+#include <poorman_ostream.hpp>
+#include <cstdint>
+
+#ifdef OPENMPTL_SIMULATION
+#  include <chrono>
+#else
+#  include <arch/dwt.hpp>
+#endif
+
+namespace mptl {
+
+/**
+ * Time source of the profiler.
+ *
+ * Target: DWT cycle counter (CYCCNT, core clock cycles).
+ * Simulation: host steady_clock, in nanoseconds.
+ *
+ * The counters are 32bit and wrap around: measured intervals must be
+ * shorter than 2^32 units (~25 seconds at 168MHz).
+ */
+struct profiler_clock
+{
+#ifdef OPENMPTL_SIMULATION
+  static constexpr const char * unit = "ns";
+
+  static void enable(void) { }
+
+  static uint32_t now(void) {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+#else
+  static constexpr const char * unit = "cyc";
+
+  /** enable the cycle counter (without resetting it) */
+  static void enable(void) {
+    dwt::enable();
+    dwt::cycle_counter_start();
+  }
+
+  static uint32_t now(void) {
+    return dwt::cycle_counter_load();
+  }
+#endif
+};
+
+
+/** Statistics of a profile point */
+struct profile_stats
+{
+  /** log2 histogram: bucket n counts intervals in [2^n, 2^(n+1)) (bucket 0: [0, 2)) */
+  static constexpr unsigned buckets = 32;
+
+  uint32_t count;
+  uint32_t last;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint64_t self_total;  /**< total without nested scopes */
+  uint32_t hist[buckets];
+
+  static unsigned bucket(uint32_t value) {
+    return value ? (31 - __builtin_clz(value)) : 0;
+  }
+
+  void reset(void) {
+    count = last = min = max = 0;
+    total = self_total = 0;
+    for(unsigned i = 0; i < buckets; i++)
+      hist[i] = 0;
+  }
+
+  void add(uint32_t value, uint32_t self) {
+    if((count == 0) || (value < min))
+      min = value;
+    if(value > max)
+      max = value;
+    count++;
+    last = value;
+    total += value;
+    self_total += self;
+    hist[bucket(value)]++;
+  }
+
+  uint32_t mean(void) const {
+    return count ? static_cast<uint32_t>(total / count) : 0;
+  }
+
+  uint32_t self_mean(void) const {
+    return count ? static_cast<uint32_t>(self_total / count) : 0;
+  }
+};
+
+
+/**
+ * Profile point base class (CRTP), holds the statistics.
+ *
+ * Example:
+ *
+ *     struct prof_screen : mptl::profile_point< prof_screen > {
+ *       static constexpr const char * name = "screen";
+ *     };
+ *
+ *     void update(void) {
+ *       mptl::profile_scope< prof_screen > scope;
+ *       ...
+ *     }
+ */
+template< typename Derived >
+struct profile_point
+{
+  static profile_stats stats;
+};
+
+template< typename Derived >
+profile_stats profile_point< Derived >::stats;
+
+
+namespace mpl {
+
+/** stack of active profile scopes (nesting) */
+template< typename = void >
+struct profile_scope_base
+{
+  static profile_scope_base * current;
+
+  profile_scope_base * parent;
+  uint32_t child_time;
+};
+
+template< typename T >
+profile_scope_base<T> * profile_scope_base<T>::current;
+
+} // namespace mpl
+
+
+/**
+ * RAII profile scope: measures the time from construction to
+ * destruction, and adds it to point_type::stats.
+ *
+ * Scopes can be nested (also across different profile points): the
+ * time spent in nested scopes is subtracted from the "self" time of
+ * the enclosing scope.
+ *
+ * NOTE: nesting is tracked globally, use profile scopes in ISRs only
+ * if they can not be preempted by other ISRs using profile scopes.
+ */
+template< typename point_type, typename clock_type = profiler_clock >
+class profile_scope
+: private mpl::profile_scope_base<>
+{
+  using base_type = mpl::profile_scope_base<>;
+
+  uint32_t start;
+
+public:
+  profile_scope(void) {
+    parent = current;
+    child_time = 0;
+    current = this;
+    start = clock_type::now();
+  }
+
+  ~profile_scope(void) {
+    uint32_t elapsed = clock_type::now() - start;  /* wrap-around safe */
+    current = parent;
+    if(parent)
+      parent->child_time += elapsed;
+    point_type::stats.add(elapsed, elapsed - child_time);
+  }
+
+  profile_scope(profile_scope const &) = delete;
+  profile_scope & operator=(profile_scope const &) = delete;
+};
+
+
+/**
+ * List of profile points (typelist-like, in order of appearance).
+ *
+ * Provides reset() and dump() of all registered points, e.g. for a
+ * terminal hook.
+ */
+template< typename... Points >
+struct profiler
+{
+  static void reset(void) {
+    int expand[] = { 0, (Points::stats.reset(), 0)... };
+    (void)expand;
+  }
+
+  static void dump(poorman::ostream<char> & cout, const char * unit = profiler_clock::unit) {
+    cout << poorman::dec;
+    int expand[] = { 0, (dump_point(cout, Points::name, Points::stats, unit), 0)... };
+    (void)expand;
+    cout << poorman::hex;
+  }
+
+private:
+
+  static void dump_point(poorman::ostream<char> & cout, const char * name, profile_stats const & st, const char * unit) {
+    cout << name << ": n=" << st.count
+         << " min=" << st.min
+         << " mean=" << st.mean()
+         << " max=" << st.max
+         << " self=" << st.self_mean()
+         << " [" << unit << "]" << poorman::endl;
+    if(st.count == 0)
+      return;
+    cout << " ";
+    for(unsigned i = 0; i < profile_stats::buckets; i++) {
+      if(st.hist[i])
+        cout << " <2^" << (i + 1) << ":" << st.hist[i];
+    }
+    cout << poorman::endl;
+  }
+};
+
+} // namespace mptl
+
+#endif // PROFILER_HPP_INCLUDED
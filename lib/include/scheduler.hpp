@@ -0,0 +1,343 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHEDULER_HPP_INCLUDED
+#define SCHEDULER_HPP_INCLUDED
+
+#include <arch/core.hpp>
+#include <typelist.hpp>
+#include <simulation.hpp>
+#include <compiler.h>
+#include <atomic>
+#include <cstdint>
+
+namespace mptl {
+
+/**
+ * Base class for scheduler tasks.
+ *
+ * A task is a class providing a "static void run(void)" function,
+ * and (by deriving from scheduler_task<>, which also makes the task a
+ * typelist element):
+ *
+ *   - period: run the task every period ticks (0: never run
+ *     periodically, the task only runs on wakeup events).
+ *
+ *   - pending(): level-triggered wakeup condition, checked by the
+ *     scheduler on every pass (e.g. "rx_fifo not empty"). Hide this
+ *     function in your task class if needed.
+ *
+ * Example:
+ *
+ *     struct blink_task : mptl::scheduler_task< systick::freq / 2 > {
+ *       static void run(void) { led::toggle(); }
+ *     };
+ */
+template< unsigned _period = 0 >
+struct scheduler_task : typelist_element
+{
+  static constexpr unsigned period = _period;
+
+  static bool pending(void) {
+    return false;
+  }
+};
+
+namespace mpl {
+
+template< typename T, typename... Tasks >
+struct scheduler_task_index;
+
+template< typename T, typename... Tasks >
+struct scheduler_task_index< T, T, Tasks... > {
+  static constexpr unsigned value = 0;
+};
+
+template< typename T, typename Head, typename... Tasks >
+struct scheduler_task_index< T, Head, Tasks... > {
+  static constexpr unsigned value = 1 + scheduler_task_index< T, Tasks... >::value;
+};
+
+template< typename T >
+struct scheduler_task_index< T > {
+  static_assert(sizeof(T) == 0, "task is not registered in scheduler<>");
+  static constexpr unsigned value = 0;
+};
+
+/** iterate Tasks in priority order (first task = highest priority) */
+template< unsigned index, typename... Tasks >
+struct scheduler_impl
+{
+  static bool ready(unsigned const *, unsigned, uint32_t) {
+    return false;
+  }
+
+  static bool run_first(unsigned *, unsigned, uint32_t, std::atomic<uint32_t> &) {
+    return false;
+  }
+
+  static void reset(unsigned *, unsigned) { }
+
+  static unsigned ticks_until_due(unsigned const *, unsigned, unsigned max_ticks) {
+    return max_ticks;
+  }
+};
+
+template< unsigned index, typename Task, typename... Tasks >
+struct scheduler_impl< index, Task, Tasks... >
+{
+  using next_type = scheduler_impl< index + 1, Tasks... >;
+
+  static constexpr uint32_t event_mask = (uint32_t)1 << index;
+
+  static bool is_ready(unsigned const * deadline, unsigned now, uint32_t events) {
+    if(events & event_mask)
+      return true;
+    /* wrap-around safe: deadline reached if (now - deadline) is not negative */
+    if(Task::period && ((int)(now - deadline[index]) >= 0))
+      return true;
+    return Task::pending();
+  }
+
+  static bool ready(unsigned const * deadline, unsigned now, uint32_t events) {
+    return is_ready(deadline, now, events) || next_type::ready(deadline, now, events);
+  }
+
+  static bool run_first(unsigned * deadline, unsigned now, uint32_t events, std::atomic<uint32_t> & event_flags) {
+    if(!is_ready(deadline, now, events))
+      return next_type::run_first(deadline, now, events, event_flags);
+
+    /* clear the event before running the task: wakeups posted
+     * while the task is running are not lost */
+    if(events & event_mask)
+      event_flags.fetch_and(~event_mask, std::memory_order_relaxed);
+
+    if(Task::period && ((int)(now - deadline[index]) >= 0)) {
+      deadline[index] += Task::period;
+      /* skip missed periods instead of running the task in a burst */
+      if((int)(now - deadline[index]) >= 0)
+        deadline[index] = now + Task::period;
+    }
+
+    Task::run();
+    return true;
+  }
+
+  static void reset(unsigned * deadline, unsigned now) {
+    deadline[index] = now;
+    next_type::reset(deadline, now);
+  }
+
+  static unsigned ticks_until_due(unsigned const * deadline, unsigned now, unsigned max_ticks) {
+    if(Task::period) {
+      int diff = (int)(deadline[index] - now);
+      if(diff <= 0)
+        return 0;
+      if((unsigned)diff < max_ticks)
+        max_ticks = diff;
+    }
+    return next_type::ticks_until_due(deadline, now, max_ticks);
+  }
+};
+
+/** flattened list of tasks, see scheduler<> */
+template< typename... Tasks >
+struct scheduler_task_list
+{
+  using impl = scheduler_impl< 0, Tasks... >;
+
+  static constexpr unsigned size = sizeof...(Tasks);
+
+  template< typename Task >
+  using index = scheduler_task_index< Task, Tasks... >;
+
+  /* used by typelist<>::pack<> */
+  template< typename... Tp >
+  struct pack {
+    using type = scheduler_task_list< Tp... >;
+  };
+};
+
+} // namespace mpl
+
+
+/**
+ * Static cooperative task scheduler.
+ *
+ * Runs the tasks (see scheduler_task<>) registered in the Tasks
+ * list, in priority order: the first task in the list has the
+ * highest priority. After each task run, the scheduler restarts
+ * checking from the highest priority task. Tasks can not be
+ * preempted by other tasks (but by interrupts, of course), and must
+ * return within reasonable time.
+ *
+ * A task is ready to run if either:
+ *
+ *   - its period has elapsed (Task::period != 0),
+ *   - notify<Task>() was called (e.g. from an ISR),
+ *   - Task::pending() returns true.
+ *
+ * If no task is ready, the core is put to sleep (wfi) until the next
+ * interrupt occurs. Make sure all wakeup sources (including the
+ * tick source for periodic tasks) raise an interrupt. With a
+ * tickless time base (see run<tickless_type>()), the tick interrupt
+ * is suppressed until the next periodic task is due.
+ *
+ * NOTE: a high priority task which is permanently ready starves all
+ * lower priority tasks.
+ *
+ * Template arguments:
+ *
+ *   - get_tick: function returning the current tick count (e.g. the
+ *     number of systick interrupts), used for periodic tasks.
+ *     Wrap-around is handled correctly.
+ *
+ *   - Tasks: list of tasks (max. 32). Nested typelist<> elements
+ *     are flattened, and void elements are removed (as in
+ *     make_reglist<>), which allows modules to contribute their
+ *     tasks as a typelist:
+ *
+ *         using usart_tasks = mptl::typelist< rx_task, tx_task >;
+ *         using scheduler = mptl::scheduler< get_tick, usart_tasks, blink_task >;
+ */
+template< unsigned (*get_tick)(void), typename... Tasks >
+class scheduler
+{
+  using task_list = typename typelist< Tasks... >::template pack< mpl::scheduler_task_list<> >::type;
+  using impl = typename task_list::impl;
+
+  static_assert(task_list::size > 0, "scheduler<> requires at least one task");
+  static_assert(task_list::size <= 32, "scheduler<> supports at most 32 tasks");
+
+  static std::atomic<uint32_t> event_flags;
+  static unsigned deadline[task_list::size];
+
+public:
+
+  static constexpr unsigned task_count = task_list::size;
+
+  /**
+   * Wake up Task, which will be run on the next scheduler pass.
+   * Safe to be called from ISRs.
+   */
+  template< typename Task >
+  static void notify(void) {
+    event_flags.fetch_or((uint32_t)1 << task_list::template index< Task >::value,
+                         std::memory_order_relaxed);
+  }
+
+  /** Clear all events, and make all periodic tasks due immediately */
+  static void reset(void) {
+    event_flags.store(0, std::memory_order_relaxed);
+    impl::reset(deadline, get_tick());
+  }
+
+  /** Returns true if any task is ready to run */
+  static bool ready(void) {
+    return impl::ready(deadline, get_tick(), event_flags.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * Returns the number of ticks until the next periodic task is due
+   * (0 if already due), or max_ticks if no periodic task is due
+   * within max_ticks. Events and pending() conditions are not taken
+   * into account.
+   */
+  static unsigned ticks_until_due(unsigned max_ticks = ~0u) {
+    return impl::ticks_until_due(deadline, get_tick(), max_ticks);
+  }
+
+  /**
+   * Run the highest priority task which is ready.
+   * Returns false if no task was ready.
+   */
+  static bool run_once(void) {
+    return impl::run_first(deadline, get_tick(), event_flags.load(std::memory_order_relaxed), event_flags);
+  }
+
+  /**
+   * Sleep until the next interrupt, unless a task is ready.
+   *
+   * Interrupts are disabled while checking for ready tasks, so that
+   * a wakeup from an ISR can not get lost between the check and the
+   * wfi instruction (a pending interrupt wakes up the core even if
+   * interrupts are disabled; the ISR is then executed right after
+   * interrupts are enabled again).
+   */
+  static void idle(void) {
+#ifdef OPENMPTL_SIMULATION
+    SIM_RELAX; // sleep a bit (don't eat up all cpu power)
+#else
+    core::disable_irq();
+    if(!ready())
+      core::wfi();
+    core::enable_irq();
+#endif
+  }
+
+  /**
+   * Tickless idle: sleep until the next periodic task is due, or
+   * until an interrupt occurs.
+   *
+   * tickless_type: time base providing "sleep(unsigned ticks)",
+   * which must be called with interrupts disabled (e.g.
+   * systick_tickless<>). Make sure get_tick is provided by the same
+   * time base.
+   */
+  template< typename tickless_type >
+  static void idle(void) {
+#ifdef OPENMPTL_SIMULATION
+    SIM_RELAX; // sleep a bit (don't eat up all cpu power)
+#else
+    core::disable_irq();
+    if(!ready())
+      tickless_type::sleep(ticks_until_due());
+    core::enable_irq();
+#endif
+  }
+
+  static void __noreturn run(void) {
+    reset();
+    while(1) {
+      if(!run_once())
+        idle();
+    }
+  }
+
+  /** Run tasks, using tickless idle (see idle<tickless_type>()) */
+  template< typename tickless_type >
+  static void __noreturn run(void) {
+    reset();
+    while(1) {
+      if(!run_once())
+        idle< tickless_type >();
+    }
+  }
+};
+
+template< unsigned (*get_tick)(void), typename... Tasks >
+std::atomic<uint32_t> scheduler< get_tick, Tasks... >::event_flags;
+
+template< unsigned (*get_tick)(void), typename... Tasks >
+unsigned scheduler< get_tick, Tasks... >::deadline[task_list::size];
+
+} // namespace mptl
+
+#endif // SCHEDULER_HPP_INCLUDED
@@ -0,0 +1,147 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SLIP_HPP_INCLUDED
+#define SLIP_HPP_INCLUDED
+
+#include <poorman_ostream.hpp>
+#include <cstdint>
+
+namespace mptl {
+
+namespace slip {
+
+  /* SLIP special characters (RFC 1055) */
+  static constexpr uint8_t END     = 0xc0;
+  static constexpr uint8_t ESC     = 0xdb;
+  static constexpr uint8_t ESC_END = 0xdc;
+  static constexpr uint8_t ESC_ESC = 0xdd;
+
+  /** CRC-16/CCITT-FALSE initial value (poly 0x1021) */
+  static constexpr uint16_t crc_init = 0xffff;
+
+  /**
+   * Update CRC-16/CCITT-FALSE with byte c (table-less).
+   *
+   * The CRC is transmitted MSB first, so that the CRC over a complete
+   * frame (including its CRC) yields 0.
+   */
+  static inline uint16_t crc16_update(uint16_t crc, uint8_t c) {
+    uint8_t x = (crc >> 8) ^ c;
+    x ^= x >> 4;
+    return (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+
+  static inline uint16_t crc16(const uint8_t * data, unsigned size, uint16_t crc = crc_init) {
+    while(size--)
+      crc = crc16_update(crc, *data++);
+    return crc;
+  }
+
+} // namespace slip
+
+
+/**
+ * SLIP encoding output stream.
+ *
+ * Escapes all bytes written, and updates the CRC of the current frame:
+ *
+ *     slip_ostream<...> out(tx_stream);
+ *     out.begin();
+ *     out.write(data, size);
+ *     out.end();   // appends CRC, END, and flushes stream_type
+ *
+ * Template arguments:
+ *
+ *   - stream_type: output stream providing put() and flush()
+ *     (e.g. fifo_stream<>)
+ */
+template<typename stream_type>
+class slip_ostream
+: public poorman::ostream<char>
+{
+  stream_type & st;
+  uint16_t crc = slip::crc_init;
+
+  void put_escaped(uint8_t c) {
+    if(c == slip::END) {
+      st.put(slip::ESC);
+      st.put(slip::ESC_END);
+    }
+    else if(c == slip::ESC) {
+      st.put(slip::ESC);
+      st.put(slip::ESC_ESC);
+    }
+    else {
+      st.put(c);
+    }
+  }
+
+public:
+
+  slip_ostream(stream_type & s) : st(s) { };
+
+  /** Start new frame */
+  void begin() {
+    crc = slip::crc_init;
+    st.put(slip::END);
+  }
+
+  /** Append CRC and terminate frame */
+  void end() {
+    uint16_t frame_crc = crc;
+    put_escaped(frame_crc >> 8);
+    put_escaped(frame_crc & 0xff);
+    st.put(slip::END);
+    st.flush();
+  }
+
+  poorman::ostream<char> & put(char c) {
+    crc = slip::crc16_update(crc, c);
+    put_escaped(c);
+    return *this;
+  }
+
+  poorman::ostream<char> & write(const char* s, unsigned int count) {
+    while(count--)
+      put(*s++);
+    return *this;
+  }
+
+  poorman::ostream<char> & puts(const char* s) {
+    while(*s)
+      put(*s++);
+    return *this;
+  }
+
+  poorman::ostream<char> & flush() {
+    st.flush();
+    return *this;
+  }
+
+  poorman::ostream<char> & endl() {
+    put('\n');
+    return *this;
+  }
+};
+
+} // namespace mptl
+
+#endif // SLIP_HPP_INCLUDED
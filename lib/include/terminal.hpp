@@ -22,7 +22,10 @@
 #define TERMINAL_HPP_INCLUDED
 
 #include <fifo_stream.hpp>
+#include <poorman_cstring.hpp>
+#include <slip.hpp>
 #include <cstring> // strcmp
+#include <cstdint>
 #include <type_traits>
 
 namespace mptl {
@@ -33,6 +36,191 @@ namespace i18n { namespace terminal {
 } } // namespace i18n::terminal
 
 
+// ----------------------------------------------------------------------------
+// terminal_args
+//
+
+/**
+ * Argument vector of a terminal command line.
+ *
+ * tokenize() splits a (mutable) command line buffer in-place at
+ * whitespace: separators are replaced by '\0', and argv[] points into
+ * the buffer. No copies, no heap. argv[0] is the command.
+ *
+ *     struct peek : public mptl::terminal_hook {
+ *       ...
+ *       void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+ *         uint32_t addr;
+ *         if(args.get_hex(1, addr)) ...
+ *       }
+ *     };
+ */
+class terminal_args
+{
+public:
+
+  static constexpr unsigned max_argc = 8;
+
+private:
+
+  const char * argv[max_argc];
+  unsigned argc = 0;
+
+public:
+
+  /**
+   * Split zero terminated buf in-place into arguments. Arguments
+   * exceeding max_argc are ignored.
+   *
+   * Returns number of arguments.
+   */
+  unsigned tokenize(char * buf) {
+    argc = 0;
+    while(*buf) {
+      while(*buf == ' ')
+        *buf++ = 0;
+      if(*buf == 0)
+        break;
+      if(argc == max_argc)
+        break;
+      argv[argc++] = buf;
+      while(*buf && (*buf != ' '))
+        buf++;
+    }
+    return argc;
+  }
+
+  /** Single-argument vector (command without arguments) */
+  void assign(const char * cmd) {
+    argv[0] = cmd;
+    argc = 1;
+  }
+
+  unsigned size() const {
+    return argc;
+  }
+
+  /** Returns argument n, or empty string if n is out of range */
+  const char * operator[](unsigned n) const {
+    return n < argc ? argv[n] : "";
+  }
+
+  /** Parse decimal (or "0x"-prefixed hexadecimal) argument n, see poorman::atoi() */
+  template<typename Tp>
+  bool get_int(unsigned n, Tp & value) const {
+    return (n < argc) && poorman::atoi(argv[n], value);
+  }
+
+  /** Parse hexadecimal argument n, see poorman::atoi_hex() */
+  template<typename Tp>
+  bool get_hex(unsigned n, Tp & value) const {
+    return (n < argc) && poorman::atoi_hex(argv[n], value);
+  }
+};
+
+
+// ----------------------------------------------------------------------------
+// terminal_job
+//
+
+/**
+ * State of a resumable (long-running) terminal hook.
+ *
+ * Hooks providing step() instead of run() are executed one step per
+ * terminal::process_input() call, keeping the main loop responsive:
+ *
+ *     struct dump : public mptl::terminal_hook {
+ *       ...
+ *       bool step(poorman::ostream<char> & cout, mptl::terminal_job & job) {
+ *         cout << table[job.state] << poorman::endl;
+ *         return ++job.state < table_size;   // true: more to do
+ *       }
+ *     };
+ *
+ * The hook is constructed for every step: keep all state in
+ * job.state (stackless coroutine style). Ctrl-C aborts a running job.
+ */
+class terminal_job
+{
+  terminal_args const * job_args;
+
+public:
+
+  using step_type = bool (*)(poorman::ostream<char> &, terminal_job &);
+
+  unsigned count;   /**< number of completed steps */
+  uint32_t state;   /**< hook defined state, 0 on first step */
+
+  void start(terminal_args const & a) {
+    job_args = &a;
+    count = 0;
+    state = 0;
+  }
+
+  /** Command line arguments (see terminal_args) */
+  terminal_args const & args() const {
+    return *job_args;
+  }
+};
+
+
+// ----------------------------------------------------------------------------
+// terminal_binary_frame
+//
+
+/**
+ * Binary request frame, passed to T::run_binary() of hooks supporting
+ * the binary protocol (see terminal::process_input()).
+ *
+ * Values are transferred raw, in native byte order (little-endian on
+ * all supported targets).
+ */
+class terminal_binary_frame
+{
+  const uint8_t * payload;
+  unsigned payload_size;
+
+public:
+
+  enum class status : uint8_t {
+    ok          = 0,
+    unknown_id  = 1,  /**< no hook with given id  */
+    unsupported = 2,  /**< hook does not implement run_binary() */
+  };
+
+  /** Response payload stream (SLIP encoded, CRC is appended on completion) */
+  poorman::ostream<char> & out;
+
+  terminal_binary_frame(const uint8_t * data, unsigned size, poorman::ostream<char> & o)
+  : payload(data), payload_size(size), out(o) { }
+
+  const uint8_t * data() const {
+    return payload;
+  }
+
+  unsigned size() const {
+    return payload_size;
+  }
+
+  /** Read request value at payload offset, returns false if out of range */
+  template<typename Tp>
+  bool get(unsigned offset, Tp & value) const {
+    static_assert(std::is_trivially_copyable<Tp>::value, "Tp must be trivially copyable");
+    if(offset + sizeof(Tp) > payload_size)
+      return false;
+    memcpy(&value, payload + offset, sizeof(Tp));
+    return true;
+  }
+
+  /** Append value to response payload */
+  template<typename Tp>
+  void put(Tp const & value) {
+    static_assert(std::is_trivially_copyable<Tp>::value, "Tp must be trivially copyable");
+    out.write(reinterpret_cast<const char *>(&value), sizeof(Tp));
+  }
+};
+
+
 // ----------------------------------------------------------------------------
 // terminal
 //
@@ -40,11 +228,25 @@ namespace i18n { namespace terminal {
 /**
  * Simple vt100-like terminal.
  *
- * Parses and executes commands from mptl::terminal_hook_list<...>,
- * and accepts simple single-word commands (see process_input()).
+ * Parses and executes commands from mptl::terminal_hook_list<...>.
+ * The command line is split into arguments (see terminal_args),
+ * the command (argv[0]) selects the hook (see process_input()).
+ *
+ * Binary mode: a SLIP END character (0xc0, never typed on a terminal)
+ * switches to binary mode, where input is parsed as SLIP framed
+ * requests (see slip.hpp):
+ *
+ *     request:  END <id> <payload...> <crc16> END
+ *     response: END <id> <status> <payload...> <crc16> END
+ *
+ * where <id> is the index of the hook in terminal_hook_list<...>
+ * (order of declaration), and <crc16> is CRC-16/CCITT-FALSE (MSB
+ * first) over all preceding bytes of the frame. Frames with bad CRC
+ * are dropped (see frame_errors()). Request id binary_exit_id
+ * switches back to text mode.
  *
  * Operates on mptl::fifo_stream<> for input/output, and provides a
- * very basic stream interface from poorman::ostream<>:
+ * very basic stream interface from poorman::static_ostream<>:
  *
  *     mptl::terminal<...> term;
  *     term.tx_stream << "hello, var=" << myvar << poorman::endl;
@@ -55,8 +257,31 @@ namespace i18n { namespace terminal {
  *           - fifo_type (of type: fifo<>)
  *           - static void flush()
  *           - static bool crlf
+ *
+ *   - _terminal_echo: echo input characters
+ *
+ *   - _history_size: number of command lines kept in history
+ *     (0: disable history)
+ *
+ *   - _job_tx_space: free space required in tx_fifo before a step
+ *     of a resumable hook is executed (maximum output of a single
+ *     step). While tx_fifo is too full, pending() returns false:
+ *     the task running process_input() yields to lower priority
+ *     tasks, and is woken again by the tx interrupt draining the
+ *     fifo.
+ *
+ * Line editing (text mode):
+ *
+ *   - Backspace (BS or DEL): delete last character
+ *   - Ctrl-U: delete line
+ *   - Up/Down (ESC [ A, ESC [ B): recall previous/next command line
+ *     from history
+ *
+ * Edits emit minimal output: a recalled line only rewrites the part
+ * differing from the current line. Input exceeding cmd_buf_size rings
+ * the bell.
  */
-template<typename Tp, bool _terminal_echo = true>
+template<typename Tp, bool _terminal_echo = true, unsigned _history_size = 4, unsigned _job_tx_space = 80>
 class terminal
 {
 public:
@@ -66,23 +291,183 @@ public:
 
   using tx_stream_type = fifo_stream< typename stream_device_type::fifo_type, stream_device_type >;
 
+  /** Output stream (static, see poorman::static_ostream) */
   tx_stream_type tx_stream;
 
+  /** Output stream (virtual), passed to terminal hooks */
+  poorman::ostream_adapter<tx_stream_type> tx_ostream;
+
   static constexpr bool         terminal_echo = _terminal_echo;
   static constexpr const char * newline = "\r\n";
   static constexpr const char * prompt  = "# ";
-  static constexpr std::size_t  cmd_buf_size = 80;  // TODO: use cmd_hooks::cmd_buf_size, which is the maximum of all command sizes (can be computed at compile-time!)
+  static constexpr std::size_t  cmd_buf_size = 80;  /* command line, including arguments */
+  static constexpr uint8_t      binary_exit_id = 0xff;
+  static constexpr unsigned     history_size = _history_size;
+  static constexpr unsigned     job_tx_space = _job_tx_space;
 
 private:
 
   char_type cmd_buf[cmd_buf_size];
   unsigned cmd_index = 0;
+  terminal_args args;
+
+  terminal_job job;
+  terminal_job::step_type job_step = nullptr;
+
+  enum class escape_state : uint8_t { none, esc, csi };
+  escape_state escape = escape_state::none;
+
+  static constexpr unsigned history_slots = history_size ? history_size : 1;
+
+  char_type history[history_slots][cmd_buf_size];
+  unsigned history_count = 0;  /* number of valid history entries */
+  unsigned history_head  = 0;  /* next history slot to write */
+  unsigned history_pos   = 0;  /* 0: new line, n: n-th most recent entry */
+
+  const char_type * history_entry(unsigned n) const {
+    return history[(history_head + history_slots - n) % history_slots];
+  }
+
+  /** Store cmd_buf (zero terminated) in history, skip consecutive duplicates */
+  void history_push(void) {
+    if((history_size == 0) || (cmd_index == 0))
+      return;
+    if(history_count && (strcmp(history_entry(1), cmd_buf) == 0))
+      return;
+    memcpy(history[history_head], cmd_buf, cmd_index + 1);
+    history_head = (history_head + 1) % history_slots;
+    if(history_count < history_size)
+      history_count++;
+  }
+
+  void cursor_left(unsigned n) {
+    if(n <= 4) {
+      /* backspaces are shorter than "ESC [ n D" */
+      while(n--)
+        tx_stream.put('\b');
+    }
+    else {
+      char buf[4];
+      char * const end = buf + sizeof(buf);
+      char * p = poorman::utoa_rev(end, n);
+      tx_stream.write("\x1b[", 2);
+      tx_stream.write(p, end - p);
+      tx_stream.put('D');
+    }
+  }
+
+  /** Replace current line by s, rewriting only the differing part */
+  void replace_line(const char_type * s) {
+    unsigned len = strlen(s);
+    unsigned common = 0;
+    while((common < cmd_index) && (common < len) && (cmd_buf[common] == s[common]))
+      common++;
+
+    if(terminal_echo) {
+      if(cmd_index > common)
+        cursor_left(cmd_index - common);
+      tx_stream.write(s + common, len - common);
+      if(len < cmd_index)
+        tx_stream.write("\x1b[K", 3);  /* erase to end of line */
+    }
+    memcpy(cmd_buf + common, s + common, len - common);
+    cmd_index = len;
+  }
+
+  void history_up(void) {
+    if(history_pos < history_count) {
+      history_pos++;
+      replace_line(history_entry(history_pos));
+    }
+  }
+
+  void history_down(void) {
+    if(history_pos > 0) {
+      history_pos--;
+      replace_line(history_pos ? history_entry(history_pos) : "");
+    }
+  }
+
+  /** Process escape sequences (ESC [ <params> <final>, or ESC O <final>) */
+  void process_escape(char c) {
+    if(escape == escape_state::esc) {
+      escape = ((c == '[') || (c == 'O')) ? escape_state::csi : escape_state::none;
+      return;
+    }
+    if(((c >= '0') && (c <= '9')) || (c == ';'))
+      return;  /* parameters: ignored */
+    escape = escape_state::none;
+    if(c == 'A')
+      history_up();
+    else if(c == 'B')
+      history_down();
+  }
+
+  bool binary_mode = false;
+  bool slip_escape = false;
+  bool frame_error = false;
+  unsigned frame_error_count = 0;
+
+  template<typename cmd_hooks>
+  void execute_frame(void) {
+    const uint8_t * frame = reinterpret_cast<const uint8_t *>(cmd_buf);
+    if(frame_error || (cmd_index < 3) || (slip::crc16(frame, cmd_index) != 0)) {
+      frame_error_count++;
+      return;
+    }
+
+    uint8_t id = frame[0];
+    slip_ostream<tx_stream_type> out(tx_stream);
+    out.begin();
+    out.put(id);
+    if(id == binary_exit_id) {
+      out.put(static_cast<char>(terminal_binary_frame::status::ok));
+      binary_mode = false;
+    }
+    else {
+      terminal_binary_frame request(frame + 1, cmd_index - 3, out);
+      cmd_hooks::execute_binary(id, request);
+    }
+    out.end();
+
+    if(!binary_mode)
+      tx_stream << prompt;
+  }
+
+  template<typename cmd_hooks>
+  void process_binary(uint8_t c) {
+    if(c == slip::END) {
+      if(cmd_index || frame_error)
+        execute_frame<cmd_hooks>();
+      cmd_index = 0;
+      slip_escape = false;
+      frame_error = false;
+      return;
+    }
+    if(slip_escape) {
+      slip_escape = false;
+      if(c == slip::ESC_END)
+        c = slip::END;
+      else if(c == slip::ESC_ESC)
+        c = slip::ESC;
+      else
+        frame_error = true;
+    }
+    else if(c == slip::ESC) {
+      slip_escape = true;
+      return;
+    }
+    if(cmd_index < cmd_buf_size)
+      cmd_buf[cmd_index++] = c;
+    else
+      frame_error = true;
+  }
 
 public:
 
   using resources = typename stream_device_type::resources;
 
-  terminal() : tx_stream(stream_device_type::tx_fifo) { }
+  terminal() : tx_stream(stream_device_type::tx_fifo), tx_ostream(tx_stream) { }
 
   void open() const {
     stream_device_type::open();
@@ -90,35 +475,130 @@ public:
 
   void close() {
     stream_device_type::close();
+    job_step = nullptr;
     cmd_index = 0;
+    history_pos = 0;
+    escape = escape_state::none;
+    binary_mode = false;
+  }
+
+  bool is_binary_mode() const {
+    return binary_mode;
+  }
+
+  /** True if a resumable hook is running */
+  bool is_busy() const {
+    return job_step != nullptr;
+  }
+
+  /** True if a step of the running resumable hook fits into tx_fifo */
+  bool job_ready() const {
+    return is_busy() && (stream_device_type::tx_fifo.write_available() >= job_tx_space);
+  }
+
+  /**
+   * True if process_input() has work to do (input available, or
+   * resumable hook running and enough space in tx_fifo).
+   */
+  bool pending() const {
+    return job_ready() || (stream_device_type::rx_fifo.read_available() != 0);
+  }
+
+  /** Number of dropped binary frames (bad CRC, framing or overflow) */
+  unsigned frame_errors() const {
+    return frame_error_count;
   }
 
+  /**
+   * Process input characters from rx_fifo, and execute commands.
+   *
+   * While a resumable hook is running (see terminal_job), a single
+   * step is executed per call (only if tx_fifo has job_tx_space
+   * free), and all input except Ctrl-C (which aborts the job) is
+   * discarded.
+   */
   template<typename cmd_hooks>
   void process_input(void)
   {
     bool flush_tx = false;
     char c;
+
+    if(job_step) {
+      while(stream_device_type::rx_fifo.pop(c)) {
+        if(c == 3) {  // Ctrl-C
+          job_step = nullptr;
+          tx_stream << "^C" << newline << prompt;
+          break;
+        }
+      }
+      if(job_ready() && !job_step(tx_ostream, job)) {
+        job_step = nullptr;
+        tx_stream << prompt;
+      }
+      tx_stream.flush();
+      return;
+    }
+
     while(stream_device_type::rx_fifo.pop(c)) {
       flush_tx = true;
-      if(c == 13)  // CR
+      if(binary_mode)
+      {
+        process_binary<cmd_hooks>(c);
+      }
+      else if(static_cast<uint8_t>(c) == slip::END)
+      {
+        binary_mode = true;
+        slip_escape = false;
+        frame_error = false;
+        cmd_index = 0;
+      }
+      else if(escape != escape_state::none)
+      {
+        process_escape(c);
+      }
+      else if(c == 13)  // CR
       {
         if(terminal_echo)
           tx_stream << newline;
 
         cmd_buf[cmd_index] = 0;
+        history_push();
+        history_pos = 0;
+        cmd_index = 0;
 
-        if(cmd_index) {
-          cmd_hooks::template execute<cmd_hooks>(cmd_buf, tx_stream);
+        if(args.tokenize(cmd_buf)) {
+          job_step = cmd_hooks::template execute<cmd_hooks>(args, tx_ostream, job);
+          if(job_step)
+            break;  /* resumable hook running, continue on next call */
         }
         tx_stream << prompt;
-        cmd_index = 0;
       }
-      else if((c >= 32) && (c <= 126) && (cmd_index < cmd_buf_size))
+      else if(c == 27)  // ESC
       {
-        if(terminal_echo)
-          tx_stream.put(c);
-
-        cmd_buf[cmd_index++] = c;
+        escape = escape_state::esc;
+      }
+      else if((c == 8) || (c == 127))  // BS, DEL
+      {
+        if(cmd_index) {
+          cmd_index--;
+          if(terminal_echo)
+            tx_stream.write("\b \b", 3);
+        }
+      }
+      else if(c == 21)  // Ctrl-U
+      {
+        replace_line("");
+      }
+      else if((c >= 32) && (c <= 126))
+      {
+        if(cmd_index < cmd_buf_size - 1) {
+          if(terminal_echo)
+            tx_stream.put(c);
+          cmd_buf[cmd_index++] = c;
+        }
+        else if(terminal_echo) {
+          tx_stream.put('\a');  // BEL: line full
+        }
       }
     }
     if(flush_tx)
@@ -150,59 +630,297 @@ namespace mpl
   struct max<T, Args...> {
     static constexpr std::size_t value = T > max<Args...>::value ? T : max<Args...>::value;
   };
-}
 
+  /** strlen(), usable in constant expressions (also on clang) */
+  static constexpr std::size_t const_strlen(const char * s) {
+    return *s ? 1 + const_strlen(s + 1) : 0;
+  }
 
-template<typename... Args>
-struct terminal_hook_list;
+  /** 32bit FNV-1a hash, usable in constant expressions */
+  static constexpr uint32_t fnv1a_hash(const char * s, uint32_t h = 2166136261u) {
+    return *s ? fnv1a_hash(s + 1, (h ^ static_cast<unsigned char>(*s)) * 16777619u) : h;
+  }
 
-template<>
-struct terminal_hook_list<>
+  /** 32bit FNV-1a hash, runtime version (same result as fnv1a_hash()) */
+  static inline uint32_t fnv1a_hash_runtime(const char * s) {
+    uint32_t h = 2166136261u;
+    while(*s)
+      h = (h ^ static_cast<unsigned char>(*s++)) * 16777619u;
+    return h;
+  }
+
+  template<typename T>
+  struct terminal_hook_hash {
+    static constexpr uint32_t value = fnv1a_hash(T::cmd);
+  };
+
+  template<typename... Args>
+  struct terminal_hook_pack { };
+
+  template<typename T, typename pack>
+  struct terminal_hook_prepend;
+
+  template<typename T, typename... Args>
+  struct terminal_hook_prepend<T, terminal_hook_pack<Args...> > {
+    using type = terminal_hook_pack<T, Args...>;
+  };
+
+  /** insert T into sorted pack (ascending by hash), fail on hash collision */
+  template<typename T, typename pack>
+  struct terminal_hook_insert {
+    using type = terminal_hook_pack<T>;
+  };
+
+  template<typename T, typename H, typename... Args>
+  struct terminal_hook_insert<T, terminal_hook_pack<H, Args...> >
+  {
+    static_assert(terminal_hook_hash<T>::value != terminal_hook_hash<H>::value,
+                  "terminal hook command hash collision (or duplicate command)");
+
+    using type = typename std::conditional<
+      (terminal_hook_hash<T>::value < terminal_hook_hash<H>::value),
+      terminal_hook_pack<T, H, Args...>,
+      typename terminal_hook_prepend< H, typename terminal_hook_insert< T, terminal_hook_pack<Args...> >::type >::type
+      >::type;
+  };
+
+  /** sort hooks by hash of their command string (insertion sort) */
+  template<typename... Args>
+  struct terminal_hook_sort {
+    using type = terminal_hook_pack<>;
+  };
+
+  template<typename T, typename... Args>
+  struct terminal_hook_sort<T, Args...> {
+    using type = typename terminal_hook_insert< T, typename terminal_hook_sort<Args...>::type >::type;
+  };
+
+  struct terminal_hook_entry {
+    uint32_t hash;
+    const char * cmd;
+    void (*run)(poorman::ostream<char> &, terminal_args const &);
+    terminal_job::step_type step;  /**< nullptr if not resumable */
+  };
+
+  /** call T::run(cout, args) if available */
+  template<typename T>
+  static auto terminal_hook_invoke(T & hook, poorman::ostream<char> & cout, terminal_args const & args, int)
+    -> decltype(hook.run(cout, args), void())
+  {
+    hook.run(cout, args);
+  }
+
+  /** fallback: call T::run(cout) (hook does not take arguments) */
+  template<typename T>
+  static void terminal_hook_invoke(T & hook, poorman::ostream<char> & cout, terminal_args const &, long) {
+    hook.run(cout);
+  }
+
+  template<typename T>
+  static void terminal_hook_run(poorman::ostream<char> & cout, terminal_args const & args) {
+    T hook;
+    terminal_hook_invoke(hook, cout, args, 0);
+  }
+
+  template<typename T>
+  static bool terminal_hook_step(poorman::ostream<char> & cout, terminal_job & job) {
+    T hook;
+    bool more = hook.step(cout, job);
+    job.count++;
+    return more;
+  }
+
+  /** true if T provides step(poorman::ostream<char> &, terminal_job &) */
+  template<typename T>
+  struct terminal_hook_is_resumable {
+    template<typename U>
+    static auto test(int) -> decltype(std::declval<U &>().step(std::declval<poorman::ostream<char> &>(), std::declval<terminal_job &>()), std::true_type());
+    template<typename U>
+    static std::false_type test(long);
+    static constexpr bool value = decltype(test<T>(0))::value;
+  };
+
+  template<typename T, bool resumable = terminal_hook_is_resumable<T>::value>
+  struct terminal_hook_functions {
+    static constexpr void (*run)(poorman::ostream<char> &, terminal_args const &) = &terminal_hook_run<T>;
+    static constexpr terminal_job::step_type step = nullptr;
+  };
+
+  template<typename T>
+  struct terminal_hook_functions<T, true> {
+    static constexpr void (*run)(poorman::ostream<char> &, terminal_args const &) = nullptr;
+    static constexpr terminal_job::step_type step = &terminal_hook_step<T>;
+  };
+
+  /** call T::run_binary(frame) if available */
+  template<typename T>
+  static auto terminal_hook_invoke_binary(T & hook, terminal_binary_frame & frame, int)
+    -> decltype(hook.run_binary(frame), void())
+  {
+    frame.out.put(static_cast<char>(terminal_binary_frame::status::ok));
+    hook.run_binary(frame);
+  }
+
+  /** fallback: hook does not support binary protocol */
+  template<typename T>
+  static void terminal_hook_invoke_binary(T &, terminal_binary_frame & frame, long) {
+    frame.out.put(static_cast<char>(terminal_binary_frame::status::unsupported));
+  }
+
+  template<typename T>
+  static void terminal_hook_run_binary(terminal_binary_frame & frame) {
+    T hook;
+    terminal_hook_invoke_binary(hook, frame, 0);
+  }
+
+  /**
+   * Lookup table of {hash, cmd, run}, sorted by hash.
+   *
+   * find() computes the hash of the command string, performs a binary
+   * search on the table and confirms the match with a single strcmp().
+   */
+  template<typename pack>
+  struct terminal_hook_table;
+
+  template<>
+  struct terminal_hook_table< terminal_hook_pack<> > {
+    static const terminal_hook_entry * find(const char *) { return nullptr; }
+  };
+
+  template<typename... Args>
+  struct terminal_hook_table< terminal_hook_pack<Args...> >
+  {
+    static constexpr std::size_t size = sizeof...(Args);
+    static constexpr terminal_hook_entry value[size] = {
+      { terminal_hook_hash<Args>::value, Args::cmd, terminal_hook_functions<Args>::run, terminal_hook_functions<Args>::step }...
+    };
+
+    static const terminal_hook_entry * find(const char * cmd) {
+      const uint32_t hash = fnv1a_hash_runtime(cmd);
+      std::size_t lo = 0;
+      std::size_t hi = size;
+      while(lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        if(value[mid].hash < hash)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      if((lo < size) && (value[lo].hash == hash) && (strcmp(value[lo].cmd, cmd) == 0))
+        return &value[lo];
+      return nullptr;
+    }
+  };
+
+  template<typename... Args>
+  constexpr terminal_hook_entry terminal_hook_table< terminal_hook_pack<Args...> >::value[];
+} // namespace mpl
+
+
+/**
+ * List of terminal hooks.
+ *
+ * Each hook T must provide:
+ *
+ *   - static constexpr const char * cmd
+ *   - static constexpr const char * desc
+ *   - void run(poorman::ostream<char> &), or
+ *     void run(poorman::ostream<char> &, terminal_args const &)
+ *     for hooks taking arguments, or
+ *     bool step(poorman::ostream<char> &, terminal_job &)
+ *     for resumable hooks (see terminal_job)
+ *
+ * Hooks supporting the binary protocol additionally provide:
+ *
+ *   - void run_binary(terminal_binary_frame &)
+ *
+ * Binary requests address hooks by index (order of declaration).
+ *
+ * Command dispatch is done on a table sorted by the (compile-time)
+ * hash of T::cmd: one hash, one binary search, one strcmp().
+ * Duplicate commands or hash collisions are detected at compile time.
+ */
+template<typename... Args>
+struct terminal_hook_list
 {
-  template<typename HL>
-  static void execute(const char * cmd_buf, poorman::ostream<char> & cout) {
-    if(strcmp("help", cmd_buf) == 0) {
+  using table_type = mpl::terminal_hook_table< typename mpl::terminal_hook_sort<Args...>::type >;
+
+  /** maximum length of all commands (minimum 8, for formatting help text) */
+  static constexpr unsigned cmd_maxlen = mpl::max<8, mpl::const_strlen(Args::cmd)...>::value;
+
+  /**
+   * Execute hook matching args[0].
+   *
+   * For resumable hooks, the first step is executed. If it returns
+   * true (more to do), the step function is returned: call it with
+   * job until it returns false.
+   */
+  template<typename HL = terminal_hook_list>
+  static terminal_job::step_type execute(terminal_args const & args, poorman::ostream<char> & cout, terminal_job & job) {
+    const mpl::terminal_hook_entry * hook = table_type::find(args[0]);
+    if(hook && hook->step) {
+      job.start(args);
+      if(hook->step(cout, job))
+        return hook->step;
+    }
+    else if(hook) {
+      hook->run(cout, args);
+    }
+    else if(strcmp("help", args[0]) == 0) {
       cout << i18n::terminal::cmd_list << poorman::endl;
       HL::template list<HL>(cout);
     }
     else {
-      cout << cmd_buf << i18n::terminal::cmd_notfound << poorman::endl;
+      cout << args[0] << i18n::terminal::cmd_notfound << poorman::endl;
     }
+    return nullptr;
   }
 
-  template<typename HL>
-  static void list(poorman::ostream<char> &) { }
-};
-
-template<typename T, typename... Args>
-struct terminal_hook_list<T, Args...> {
-
-  template<typename HL>
-  static void execute(const char * cmd_buf, poorman::ostream<char> & cout) {
-    if(strcmp(T::cmd, cmd_buf) == 0) {
-      T().run(cout);
-    }
-    else {
-      terminal_hook_list<Args...>::template execute<HL>(cmd_buf, cout);
+  /** Execute hook matching args[0], resumable hooks are run to completion */
+  template<typename HL = terminal_hook_list>
+  static void execute(terminal_args const & args, poorman::ostream<char> & cout) {
+    terminal_job job;
+    terminal_job::step_type step = execute<HL>(args, cout, job);
+    if(step) {
+      while(step(cout, job)) { }
     }
   }
 
-#ifdef CONFIG_CLANG
-  // for some reason, clang-3.3 does not treat strlen() as constexpr
-  static constexpr unsigned cmd_maxlen = 8;
-#else
-  /** maximum length of all commands (minimum 8, for formatting help text) */
-  static constexpr unsigned cmd_maxlen = mpl::max<8, strlen(T::cmd), strlen(Args::cmd)...>::value;
-#endif
+  /** Execute hook number id (binary protocol), writes status and response payload */
+  static void execute_binary(unsigned id, terminal_binary_frame & frame) {
+    using run_binary_type = void (*)(terminal_binary_frame &);
+    static constexpr run_binary_type binary_table[sizeof...(Args) + 1] = {
+      &mpl::terminal_hook_run_binary<Args>..., nullptr
+    };
+    if(id < sizeof...(Args))
+      binary_table[id](frame);
+    else
+      frame.out.put(static_cast<char>(terminal_binary_frame::status::unknown_id));
+  }
 
-  template<typename HL>
+  /** Execute hook matching cmd (no arguments) */
+  template<typename HL = terminal_hook_list>
+  static void execute(const char * cmd, poorman::ostream<char> & cout) {
+    terminal_args args;
+    args.assign(cmd);
+    execute<HL>(args, cout);
+  }
+
+  template<typename HL = terminal_hook_list>
   static void list(poorman::ostream<char> & cout) {
+    /* print in order of declaration (expands to one list_hook() per hook) */
+    int expand[] = { 0, (list_hook<HL, Args>(cout), 0)... };
+    (void)expand;
+  }
+
+private:
+
+  template<typename HL, typename T>
+  static void list_hook(poorman::ostream<char> & cout) {
     cout << "   " << T::cmd;
     for(int n = HL::cmd_maxlen - strlen(T::cmd) + 3 ; n > 0; n--)
       cout.put(' ');
     cout << T::desc << poorman::endl;
-
-    terminal_hook_list<Args...>::template list<HL>(cout);
   }
 };
 
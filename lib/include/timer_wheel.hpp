@@ -0,0 +1,300 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TIMER_WHEEL_HPP_INCLUDED
+#define TIMER_WHEEL_HPP_INCLUDED
+
+#include <atomic>
+
+namespace mptl {
+
+/**
+ * Software timer, armed by timer_wheel<>::start().
+ *
+ * Static (zero-initialized) timers are not armed. Do not modify the
+ * members while the timer is armed.
+ */
+struct timer_wheel_timer
+{
+  using callback_type = void (*)(void);
+
+  timer_wheel_timer *  next;
+  timer_wheel_timer ** pprev;     /**< link pointing to this timer (nullptr if not armed) */
+  unsigned             expires;   /**< expiry tick */
+  unsigned             period;    /**< re-arm period in ticks (0: one-shot) */
+  callback_type        callback;
+
+  bool armed(void) const {
+    return pprev != nullptr;
+  }
+};
+
+
+/**
+ * Hierarchical timer wheel.
+ *
+ * Manages software timers (timer_wheel_timer) with O(1) start and
+ * cancel, advanced by calling advance() on every tick (e.g. from the
+ * systick isr). The cost of advance() per tick is constant, plus
+ * the expired timers (and a cascade of a higher level slot every
+ * 2^slot_bits ticks).
+ *
+ * Level 0 holds the timers expiring within the next 2^slot_bits
+ * ticks, level n the timers expiring within 2^(slot_bits*(n+1))
+ * ticks. Timers exceeding the range of the wheel are parked in the
+ * top level, and re-inserted on cascade.
+ *
+ * The timer callbacks are called from advance() context (usually
+ * ISR), and must not call start() or cancel(). Periodic timers are
+ * re-armed automatically. Typical callbacks are
+ * scheduler<>::notify<Task>, or a function posting a message to a
+ * message_queue<>.
+ *
+ * Concurrency: start() and cancel() must be called from the main
+ * loop only (thread mode). While the main loop modifies the wheel,
+ * advance() does not block, but defers the advancing to the end of
+ * the modification.
+ *
+ * NOTE: timer_wheel<> has no constructor, make sure to call reset()
+ * before use.
+ */
+template< unsigned slot_bits = 4, unsigned levels = 4 >
+class timer_wheel
+{
+  static_assert(slot_bits > 0, "slot_bits must be greater than zero");
+  static_assert(levels > 0, "timer_wheel requires at least one level");
+  static_assert(slot_bits * levels < 32, "timer_wheel range exceeds 32bit ticks");
+
+public:
+
+  using timer = timer_wheel_timer;
+  using callback_type = timer::callback_type;
+
+  static constexpr unsigned slots = 1u << slot_bits;
+
+  /** timers expiring within range ticks are not re-inserted on cascade */
+  static constexpr unsigned range = 1u << (slot_bits * levels);
+
+private:
+
+  static constexpr unsigned slot_mask = slots - 1;
+
+  timer * slot[levels][slots];
+  unsigned current;  /**< last processed tick */
+
+  std::atomic<bool> locked;
+  std::atomic<bool> advance_deferred;
+  std::atomic<unsigned> deferred_tick;
+
+  void lock(void) {
+    /* never spins on target: advance() holds the lock in ISR context
+     * only, which completes before the main loop continues */
+    while(locked.exchange(true, std::memory_order_acquire)) { }
+  }
+
+  bool try_lock(void) {
+    return !locked.exchange(true, std::memory_order_acquire);
+  }
+
+  void unlock(void) {
+    locked.store(false, std::memory_order_release);
+    if(advance_deferred.exchange(false, std::memory_order_acq_rel))
+      advance(deferred_tick.load(std::memory_order_relaxed));
+  }
+
+  /** set deferred_tick to now, unless it already holds a later tick (never moves backwards) */
+  void update_deferred_tick(unsigned now) {
+    unsigned prev = deferred_tick.load(std::memory_order_relaxed);
+    while(((int)(now - prev) > 0) &&
+          !deferred_tick.compare_exchange_weak(prev, now, std::memory_order_relaxed)) { }
+  }
+
+  static void link(timer * & head, timer & t) {
+    t.next = head;
+    if(head)
+      head->pprev = &t.next;
+    head = &t;
+    t.pprev = &head;
+  }
+
+  static void unlink(timer & t) {
+    *t.pprev = t.next;
+    if(t.next)
+      t.next->pprev = t.pprev;
+    t.next = nullptr;
+    t.pprev = nullptr;
+  }
+
+  void insert(timer & t) {
+    unsigned delta = t.expires - current;
+    if((int)delta <= 0) {
+      /* expires on current tick (cascade only, see start()) */
+      link(slot[0][current & slot_mask], t);
+      return;
+    }
+    for(unsigned level = 0; level < levels; level++) {
+      if(delta < (1u << (slot_bits * (level + 1)))) {
+        link(slot[level][(t.expires >> (slot_bits * level)) & slot_mask], t);
+        return;
+      }
+    }
+    /* out of range: park in the top level slot which is cascaded last */
+    constexpr unsigned top_shift = slot_bits * (levels - 1);
+    link(slot[levels - 1][((current >> top_shift) - 1) & slot_mask], t);
+  }
+
+  void cascade(void) {
+    for(unsigned level = 1; level < levels; level++) {
+      unsigned index = (current >> (slot_bits * level)) & slot_mask;
+      timer * t = slot[level][index];
+      slot[level][index] = nullptr;
+      while(t) {
+        timer * next = t->next;
+        t->next = nullptr;
+        t->pprev = nullptr;
+        insert(*t);
+        t = next;
+      }
+      if(index != 0)
+        break;
+    }
+  }
+
+  void expire(void) {
+    timer * & head = slot[0][current & slot_mask];
+    timer * t = head;
+    head = nullptr;
+    while(t) {
+      timer * next = t->next;
+      t->next = nullptr;
+      t->pprev = nullptr;
+      if(t->expires != current) {
+        insert(*t);  /* not expected, but keep the timer */
+      }
+      else {
+        if(t->period) {
+          t->expires += t->period;
+          insert(*t);
+        }
+        t->callback();
+      }
+      t = next;
+    }
+  }
+
+public:
+
+  /** Cancel all timers, and set the current tick */
+  void reset(unsigned now) {
+    for(unsigned level = 0; level < levels; level++)
+      for(unsigned i = 0; i < slots; i++)
+        slot[level][i] = nullptr;
+    current = now;
+    deferred_tick.store(now, std::memory_order_relaxed);
+    locked.store(false, std::memory_order_relaxed);
+    advance_deferred.store(false, std::memory_order_relaxed);
+  }
+
+  /** Last tick processed by advance() */
+  unsigned now(void) const {
+    return current;
+  }
+
+  /**
+   * Arm timer t to expire ticks (>= 1) ticks from now, and call
+   * callback. If period is not zero, the timer is re-armed to expire
+   * every period ticks after the first expiry.
+   *
+   * Re-arms the timer if already armed.
+   */
+  void start(timer & t, unsigned ticks, callback_type callback, unsigned period = 0) {
+    lock();
+    if(t.armed())
+      unlink(t);
+    t.expires  = current + (ticks ? ticks : 1);
+    t.period   = period;
+    t.callback = callback;
+    insert(t);
+    unlock();
+  }
+
+  /** Cancel timer t. Returns false if the timer was not armed. */
+  bool cancel(timer & t) {
+    lock();
+    bool armed = t.armed();
+    if(armed)
+      unlink(t);
+    unlock();
+    return armed;
+  }
+
+  /**
+   * Process all ticks up to (and including) now, and call the
+   * callbacks of the expired timers.
+   *
+   * Ticks older than the latest tick passed to advance() are
+   * ignored: unlock() can pass a stale tick if the isr advances the
+   * wheel in between (the wheel never runs backwards).
+   */
+  void advance(unsigned now) {
+    update_deferred_tick(now);
+    if(!try_lock()) {
+      advance_deferred.store(true, std::memory_order_release);
+      return;
+    }
+    now = deferred_tick.load(std::memory_order_relaxed);
+    while((int)(now - current) > 0) {
+      current++;
+      if((current & slot_mask) == 0)
+        cascade();
+      expire();
+    }
+    unlock();
+  }
+
+  /**
+   * Returns the number of ticks (from now()) until the wheel needs
+   * to be advanced next: either the expiry of the next timer, or the
+   * next cascade of a non-empty slot. Returns max_ticks if there is
+   * nothing to do within max_ticks.
+   *
+   * Used for tickless idle: costs O(levels * slots).
+   */
+  unsigned ticks_until_next(unsigned max_ticks = ~0u) const {
+    unsigned result = max_ticks;
+    for(unsigned level = 0; level < levels; level++) {
+      unsigned shift = slot_bits * level;
+      unsigned pos = current >> shift;
+      for(unsigned i = 1; i <= slots; i++) {
+        if(slot[level][(pos + i) & slot_mask]) {
+          unsigned ticks = ((pos + i) << shift) - current;
+          if(ticks < result)
+            result = ticks;
+          break;
+        }
+      }
+    }
+    return result;
+  }
+};
+
+} // namespace mptl
+
+#endif // TIMER_WHEEL_HPP_INCLUDED
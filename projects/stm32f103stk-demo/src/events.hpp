@@ -22,6 +22,7 @@
 #define EVENTS_HPP_INCLUDED
 
 #include <tinyfsm.hpp>
+#include <cstdint>
 
 struct EvJoystickButton : public tinyfsm::Event { };
 struct EvJoystickUp     : public tinyfsm::Event { };
@@ -30,4 +31,18 @@ struct EvJoystickLeft   : public tinyfsm::Event { };
 struct EvJoystickRight  : public tinyfsm::Event { };
 struct EvJoystickCenter : public tinyfsm::Event { };
 
+
+/* Event records: posted from ISR context to Kernel::event_queue, and
+ * dispatched in batches from the kernel main loop.
+ */
+struct EventRecord {
+  enum class Type : uint8_t {
+    rtc_second,
+  };
+
+  uint32_t timestamp;  /* systick count */
+  Type     type;
+  uint32_t value;
+};
+
 #endif
@@ -28,8 +28,7 @@
 
 #include <terminal.hpp>
 #include <debouncer.hpp>
-#include <arch/dwt.hpp>  // cycle_counter
-#include <simulation.hpp>
+#include <scheduler.hpp>
 
 
 //#define DEBUG_ASSERT_REGISTER_AGAINST_FIXED_VALUES
@@ -49,9 +48,21 @@ static_assert(mptl::make_reglist< Kernel::resources >::merged_regmask< mptl::GPI
 #endif // DEBUG_ASSERT_REGISTER_AGAINST_FIXED_VALUES
 
 Kernel::terminal_type Kernel::terminal;
+Kernel::event_queue_type Kernel::event_queue;
+Kernel::trace_type Kernel::trace;
+mptl::fifo_statistics Kernel::rx_fifo_stat;
+mptl::fifo_statistics Kernel::tx_fifo_stat;
+
+Kernel::buffer_pool_type Kernel::buffer_pool;
 
 void Kernel::init(void)
 {
+  event_queue.reset();
+  trace.reset();
+  profiler::reset();
+  isr_trace::reset< resources >();
+  mptl::profiler_clock::enable();
+
   /* set all register from Kernel::resources<> */
   mptl::make_reglist< resources >::reset_to();
 
@@ -66,29 +77,20 @@ void Kernel::init(void)
   joy::enable();
 }
 
-void Kernel::run(void)
+/* screen rows, owned by Kernel::run() (see Kernel::run()) */
+struct ScreenRows
 {
-  char joytext_buf[16];
-  char * const joypos_text = &joytext_buf[8];
-  std::strcpy(joytext_buf, "joy : o center");
-
-  mptl::cycle_counter cycle_counter;
-  debouncer< joy::position,
-             joy::get_position_blocking,
-             time::get_systick,
-             time::systick::freq,
-             10 > joypos(joy::position::center);
-
-  /* define the screen item list */
   ScreenItemList item_list;
-  TextRow    title0    (item_list, ">> OpenMPTL <<");
-  TextRow    title1    (item_list, "--------------");
-  TextRow    joytext   (item_list, joytext_buf);
-  DataRow    rtc_sec   (item_list, "rtc");
-  DataRow    tick      (item_list, "tick", 0, NumberBase::hex);
-  DataRow    cycle     (item_list, "cyc");
-  DataRow    irq_count (item_list, "#irq", 0, NumberBase::hex);
-  DataRow    eirq      (item_list, "eirq", 0, NumberBase::hex);
+  char joytext_buf[16] = "joy : o center";
+
+  TextRow    title0    { item_list, ">> OpenMPTL <<" };
+  TextRow    title1    { item_list, "--------------" };
+  TextRow    joytext   { item_list, joytext_buf };
+  DataRow    rtc_sec   { item_list, "rtc" };
+  DataRow    tick      { item_list, "tick", 0, NumberBase::hex };
+  DataRow    joy_cyc   { item_list, "tjoy" };  /* JoystickTask duration (last run, cycles) */
+  DataRow    irq_count { item_list, "#irq", 0, NumberBase::hex };
+  DataRow    eirq      { item_list, "eirq", 0, NumberBase::hex };
 
   // Note: it is also possible to define the ScreenItems without the
   // item_list, and use an initializer list. Initializer
@@ -98,62 +100,138 @@ void Kernel::run(void)
   // TextRow title0(">> OpenMPTL <<");
   //  <...>
   //  ScreenItemList item_list{ &title0, <...> };
+};
 
-  Screen::set_item_list(item_list);
+static ScreenRows * rows;
 
-  /* open terminal and print welcome message */
-  terminal.open();
-  terminal.tx_stream << "\r\n\r\nWelcome to OpenMPTL terminal console!\r\n# " << poorman::flush;
+/*
+ * poll terminal (runs whenever input is available). Steps of a
+ * resumable hook (e.g. "dump") only run while tx_fifo has room for
+ * them (see terminal::pending()): lower priority tasks are not
+ * starved, and the tx interrupt wakes us up again.
+ */
+struct TerminalTask : mptl::scheduler_task<>
+{
+  static bool pending(void) { return Kernel::terminal.pending(); }
+  static void run(void) {
+    mptl::profile_scope< Kernel::prof_terminal > scope;
+    Kernel::terminal.process_input< terminal_hooks::commands >();
+  }
+};
 
-  /* start kernel loop */
-  fsm_list::start();
-  while(1)
-  {
-    cycle_counter.start();
-
-    /* poll joystick */
-    if(joypos.poll()) {
-      switch(joypos) {
-      case joy::position::up:
-        send_event(EvJoystickUp());
-        std::strcpy(joypos_text, "up");
-        break;
-      case joy::position::down:
-        send_event(EvJoystickDown());
-        std::strcpy(joypos_text, "down");
-        break;
-      case joy::position::left:
-        send_event(EvJoystickLeft());
-        std::strcpy(joypos_text, "left");
-        break;
-      case joy::position::right:
-        send_event(EvJoystickRight());
-        std::strcpy(joypos_text, "right");
-        break;
-      case joy::position::center:
-        send_event(EvJoystickCenter());
-        std::strcpy(joypos_text, "center");
-        break;
-      }
-    }
-    joytext_buf[6] = joy::button_pressed() ? 'x' : 'o';
+/* dispatch event records posted by ISRs */
+struct EventTask : mptl::scheduler_task<>
+{
+  static bool pending(void) { return Kernel::event_queue.read_available() != 0; }
+  static void run(void) {
+    mptl::profile_scope< Kernel::prof_events > scope;
+    Kernel::event_queue.drain([](EventRecord const & ev) {
+        switch(ev.type) {
+        case EventRecord::Type::rtc_second:
+          rows->rtc_sec = ev.value;
+          Kernel::rx_fifo_stat.update(Kernel::usart_stream_device::rx_fifo);
+          Kernel::tx_fifo_stat.update(Kernel::usart_stream_device::tx_fifo);
+          break;
+        }
+      });
+  }
+};
 
-    /* poll terminal */
-    terminal.process_input< terminal_hooks::commands >();
+/* poll joystick (ADC conversion) every 20ms */
+struct JoystickTask : mptl::scheduler_task< Kernel::time::systick::freq / 50 >
+{
+  using joy  = Kernel::joy;
+  using time = Kernel::time;
+
+  static debouncer< joy::position,
+                    joy::get_position_blocking,
+                    time::get_systick,
+                    time::systick::freq,
+                    10 > joypos;
 
-    /* update screen rows */
-    rtc_sec   = time::get_rtc_seconds();
-    tick      = time::get_systick();
-    irq_count = usart_stream_device::irq_count;
-    eirq      = usart_stream_device::irq_errors;
+  static void run(void);
+};
+
+/* update screen rows and lcd (SPI transfer) every 250ms, or on joystick event */
+struct ScreenTask : mptl::scheduler_task< Kernel::time::systick::freq / 4 >
+{
+  static void run(void);
+};
 
-    cycle_counter.stop();
-    cycle     = cycle_counter.get();
+/* tasks in priority order (see mptl::scheduler<>) */
+using scheduler = mptl::scheduler<
+  Kernel::time::get_systick,
+  TerminalTask,
+  EventTask,
+  JoystickTask,
+  ScreenTask
+  >;
 
-    /* update screen */
-    lcd::enable();
-    Screen::update();
+decltype(JoystickTask::joypos) JoystickTask::joypos(joy::position::center);
 
-    SIM_RELAX; // sleep a bit (don't eat up all cpu power)
+void JoystickTask::run(void)
+{
+  char * const joypos_text = &rows->joytext_buf[8];
+  char const button = joy::button_pressed() ? 'x' : 'o';
+
+  mptl::profile_scope< Kernel::prof_joystick > scope;
+
+  if(joypos.poll()) {
+    MPTL_LOG(Kernel::trace, "joystick: position=%u tick=%u", joy::position(joypos), time::get_systick());
+    switch(joypos) {
+    case joy::position::up:
+      send_event(EvJoystickUp());
+      std::strcpy(joypos_text, "up");
+      break;
+    case joy::position::down:
+      send_event(EvJoystickDown());
+      std::strcpy(joypos_text, "down");
+      break;
+    case joy::position::left:
+      send_event(EvJoystickLeft());
+      std::strcpy(joypos_text, "left");
+      break;
+    case joy::position::right:
+      send_event(EvJoystickRight());
+      std::strcpy(joypos_text, "right");
+      break;
+    case joy::position::center:
+      send_event(EvJoystickCenter());
+      std::strcpy(joypos_text, "center");
+      break;
+    }
+    scheduler::notify< ScreenTask >();
+  }
+  if(rows->joytext_buf[6] != button) {
+    rows->joytext_buf[6] = button;
+    scheduler::notify< ScreenTask >();
   }
 }
+
+void ScreenTask::run(void)
+{
+  mptl::profile_scope< Kernel::prof_screen > scope;
+
+  rows->tick      = Kernel::time::get_systick();
+  rows->joy_cyc   = Kernel::prof_joystick::stats.last;
+  rows->irq_count = Kernel::usart_stream_device::irq_count;
+  rows->eirq      = Kernel::usart_stream_device::irq_errors;
+
+  Kernel::lcd::enable();
+  Screen::update();
+}
+
+void Kernel::run(void)
+{
+  ScreenRows screen_rows;
+  rows = &screen_rows;
+  Screen::set_item_list(screen_rows.item_list);
+
+  /* open terminal and print welcome message */
+  terminal.open();
+  terminal.tx_stream << "\r\n\r\nWelcome to OpenMPTL terminal console!\r\n# " << poorman::flush;
+
+  /* start kernel loop: run tasks, sleep (tickless) when idle */
+  fsm_list::start();
+  scheduler::run< time::tickless >();
+}
@@ -31,9 +31,15 @@
 #include <arch/gpio.hpp>
 #include <arch/nvic.hpp>
 #include <terminal.hpp>
+#include <message_queue.hpp>
+#include <deferred_log.hpp>
+#include <profiler.hpp>
+#include <isr_trace.hpp>
+#include <block_pool.hpp>
 #include <typelist.hpp>
 #include <compiler.h>
 #include "time.hpp"
+#include "events.hpp"
 
 struct Kernel
 {
@@ -55,7 +61,8 @@ struct Kernel
     usart::enable_tx
     >;
 
-  using usart_stream_device = mptl::usart_irq_stream< usart, mptl::ring_buffer<char, 512>, true, true >; /* irq debug enabled */
+  using usart_fifo = mptl::counted_ring_buffer<char, 512>;
+  using usart_stream_device = mptl::usart_irq_stream< usart, usart_fifo, true, true >; /* irq debug enabled */
   using terminal_type = mptl::terminal< usart_stream_device >;
 
   using spi = mptl::spi< 1, sysclk, mptl::gpio< 'A', 5 >, mptl::gpio< 'A', 6 >, mptl::gpio< 'A', 7 > >;
@@ -83,6 +90,32 @@ struct Kernel
 
   static terminal_type terminal;
 
+  /* event records posted by ISRs, drained in Kernel::run() */
+  using event_queue_type = mptl::message_queue< EventRecord, 16 >;
+  static event_queue_type event_queue;
+
+  /* deferred trace log (main loop only), see terminal hook "log" */
+  using trace_type = mptl::deferred_log< 32 >;
+  static trace_type trace;
+
+  /* profile points of the Kernel::run() tasks, see terminal hook "prof" */
+  struct prof_terminal : mptl::profile_point< prof_terminal > { static constexpr const char * name = "terminal"; };
+  struct prof_events   : mptl::profile_point< prof_events   > { static constexpr const char * name = "events";   };
+  struct prof_joystick : mptl::profile_point< prof_joystick > { static constexpr const char * name = "joystick"; };
+  struct prof_screen   : mptl::profile_point< prof_screen   > { static constexpr const char * name = "screen";   };
+  using profiler = mptl::profiler< prof_terminal, prof_events, prof_joystick, prof_screen >;
+
+  /* isr statistics (10us budget), wraps all isr's in the vector table, see terminal hook "isr" */
+  using isr_trace = mptl::isr_trace< mptl::profiler_clock, sysclk::hclk_freq / 100000 >;
+
+  /* fifo statistics, updated on EventRecord::Type::rtc_second */
+  static mptl::fifo_statistics rx_fifo_stat;
+  static mptl::fifo_statistics tx_fifo_stat;
+
+  /* 1k buffers (no heap, see syscalls.cpp), see terminal hook "pool" */
+  using buffer_pool_type = mptl::block_pool< 1024, 2 >;
+  static buffer_pool_type buffer_pool;
+
   /* Reset core exception: triggered on system startup (system entry point). */
   static void  __naked reset_isr(void);
 
@@ -109,6 +142,7 @@ struct Kernel
 
     usart::resources,
     usart_cfg,
+    mptl::irq_priority< typename usart::irq, 1 >,  /* preempts time isr's (no rx overrun) */
     terminal_type::resources
   >;
 };
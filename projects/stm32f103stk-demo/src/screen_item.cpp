@@ -20,6 +20,10 @@
 
 #include "screen_item.hpp"
 
+#ifndef OPENMPTL_USE_BOOST
+ScreenItemPool screen_item_pool;
+#endif
+
 void DataRow::init_buf(const char * name) {
   unsigned i = 0;
 
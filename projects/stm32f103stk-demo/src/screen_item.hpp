@@ -34,7 +34,11 @@ using ScreenItemList = boost::intrusive::list<
   >;
 #else
 # include <list>
-using ScreenItemList = std::list<ScreenItem*>;
+# include <block_pool.hpp>
+/* list nodes (two links and the item pointer) are allocated from a static pool */
+using ScreenItemPool = mptl::block_pool< 4 * sizeof(void *), 16 >;
+extern ScreenItemPool screen_item_pool;
+using ScreenItemList = std::list< ScreenItem*, mptl::pool_allocator< ScreenItem*, ScreenItemPool, &screen_item_pool > >;
 #endif // OPENMPTL_USE_BOOST
 
 
@@ -36,8 +36,9 @@ void Kernel::reset_isr(void) {
 /* Build the vector table:
  * - use irq handler from irq_handler<> traits in Kernel::resources
  * - use Kernel::error_isr as default isr
+ * - wrap irq handlers by Kernel::isr_trace
  */
-using vector_table = mptl::vector_table<&_stack_top, Kernel::resources, Kernel::error_isr>;
+using vector_table = mptl::vector_table<&_stack_top, Kernel::resources, Kernel::error_isr, Kernel::isr_trace>;
 const auto isr_vector __used __attribute__((section(".isr_vector"))) = vector_table::value;
 
 
@@ -27,35 +27,20 @@
 #include <stdint.h>
 #include <errno.h>
 
-/* define a fixed heap size for tesing purposes */
-//#define HEAP_FIXED_SIZE (1024 * 8)
-
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#ifdef HEAP_FIXED_SIZE
-char heap[HEAP_FIXED_SIZE];
-char *heap_ptr = heap;
-char *heap_end = heap + HEAP_FIXED_SIZE;
-#else
-/* NOTE: This assumes that the stack is growing down towards the heap */
-extern char end[];
-char *heap_ptr = end;
-register char *heap_end asm ("sp");  /* heap_end is current stack pointer */
-#endif
-
+/*
+ * No heap: dynamic memory is allocated from static pools (see
+ * lib/include/block_pool.hpp, Kernel::buffer_pool, screen_item_pool).
+ * Any (unintended) call to malloc() fails.
+ */
 caddr_t _sbrk(ptrdiff_t incr)
 {
-  char *chunk_start = heap_ptr;
-
-  if(heap_ptr + incr > heap_end)
-  {
-    errno = ENOMEM;
-    return (caddr_t) -1;
-  }
-  heap_ptr += incr;
-  return (caddr_t)chunk_start;
+  (void)incr;
+  errno = ENOMEM;
+  return (caddr_t) -1;
 }
 
 int _kill(int pid, int sig)
@@ -80,8 +65,10 @@ void _exit(int status)
   lcd.print_line_inv(1, "out of memory!");
   lcd.print_line(2, DataRow("stat", status            , NumberBase::hex).c_str());
   lcd.print_line(3, DataRow("err#", errno             , NumberBase::hex).c_str());
-  lcd.print_line(4, DataRow("heap", (uint32_t)heap_ptr, NumberBase::hex).c_str());
-  lcd.print_line(5, DataRow("hend", (uint32_t)heap_end, NumberBase::hex).c_str());
+  lcd.print_line(4, DataRow("buf", Kernel::buffer_pool.available()).c_str());
+#ifndef OPENMPTL_USE_BOOST
+  lcd.print_line(5, DataRow("scr", screen_item_pool.available()).c_str());
+#endif
   lcd.update();
 
   while(1);
@@ -23,6 +23,11 @@
 
 #include <terminal.hpp>
 #include <arch/scb.hpp>
+#include <arch/critical_section.hpp>
+#include <fifo.hpp>
+#include <cstring>
+#include "kernel.hpp"
+#include "screen_item.hpp"
 
 namespace terminal_hooks {
 
@@ -36,12 +41,198 @@ struct cpuid
   }
 };
 
-struct heap_eater
+struct fifo_stat
 : public mptl::terminal_hook
 {
-  static constexpr const char * cmd  = "heap";
-  static constexpr const char * desc = "allocate (leak) 1k on heap";
-  void run(poorman::ostream<char> &);
+  static constexpr const char * cmd  = "fifo";
+  static constexpr const char * desc = "fifo [reset]: prints (or resets) usart rx/tx fifo statistics";
+
+  /* masks the usart irq (and all irq's of lower priority) */
+  using usart_lock = mptl::critical_section< Kernel::resources, Kernel::usart::irq >;
+
+  template<typename fifo_type>
+  static void print(poorman::ostream<char> & cout, const char * name, fifo_type const & fifo, mptl::fifo_statistics stat) {
+    fifo.get_statistics(stat);  /* live values, keep overrun_delta from last (periodic) update */
+    cout << name << poorman::dec << poorman::endl;
+    cout << "  size     : " << stat.size          << poorman::endl;
+    cout << "  level    : " << stat.level         << poorman::endl;
+    cout << "  peak     : " << stat.peak          << poorman::endl;
+    cout << "  burst    : " << stat.max_burst     << poorman::endl;
+    cout << "  total    : " << stat.total         << poorman::endl;
+    cout << "  overrun  : " << stat.overrun       << poorman::endl;
+    cout << "  underrun : " << stat.underrun      << poorman::endl;
+    cout << "  drops/s  : " << stat.overrun_delta << poorman::hex << poorman::endl;
+  }
+
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    if(std::strcmp(args[1], "reset") == 0) {
+      usart_lock lock;  /* reset_counter() is not thread-safe */
+      Kernel::usart_stream_device::rx_fifo.reset_counter();
+      Kernel::usart_stream_device::tx_fifo.reset_counter();
+      Kernel::rx_fifo_stat = Kernel::tx_fifo_stat = mptl::fifo_statistics();
+      return;
+    }
+    print(cout, "rx_fifo:", Kernel::usart_stream_device::rx_fifo, Kernel::rx_fifo_stat);
+    print(cout, "tx_fifo:", Kernel::usart_stream_device::tx_fifo, Kernel::tx_fifo_stat);
+  }
+
+  /** binary protocol: responds raw fifo_statistics of rx_fifo, tx_fifo */
+  void run_binary(mptl::terminal_binary_frame & frame) {
+    mptl::fifo_statistics stat = Kernel::rx_fifo_stat;
+    Kernel::usart_stream_device::rx_fifo.get_statistics(stat);
+    frame.put(stat);
+    stat = Kernel::tx_fifo_stat;
+    Kernel::usart_stream_device::tx_fifo.get_statistics(stat);
+    frame.put(stat);
+  }
+};
+
+struct peek
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "peek";
+  static constexpr const char * desc = "peek <addr>: prints 32bit word at (hex) address";
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    uint32_t addr;
+    if(!args.get_hex(1, addr) || (addr & 3)) {
+      cout << "usage: peek <addr> (hex, word aligned)" << poorman::endl;
+      return;
+    }
+    cout << addr << ": " << *reinterpret_cast<volatile uint32_t *>(addr) << poorman::endl;
+  }
+};
+
+struct poke
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "poke";
+  static constexpr const char * desc = "poke <addr> <val>: writes 32bit word to (hex) address";
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    uint32_t addr, val;
+    if(!args.get_hex(1, addr) || (addr & 3) || !args.get_int(2, val)) {
+      cout << "usage: poke <addr> <val> (addr: hex, word aligned)" << poorman::endl;
+      return;
+    }
+    *reinterpret_cast<volatile uint32_t *>(addr) = val;
+  }
+};
+
+struct memdump
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "dump";
+  static constexpr const char * desc = "dump <addr> [words]: hex dump of memory (resumable, one line per step)";
+
+  static constexpr unsigned words_per_line = 4;
+
+  bool step(poorman::ostream<char> & cout, mptl::terminal_job & job) {
+    uint32_t addr;
+    unsigned words = 64;
+    if(!job.args().get_hex(1, addr) || (addr & 3) ||
+       ((job.args().size() > 2) && !job.args().get_int(2, words))) {
+      cout << "usage: dump <addr> [words] (addr: hex, word aligned)" << poorman::endl;
+      return false;
+    }
+
+    /* job.state: number of words already printed */
+    addr += job.state * 4;
+    cout << addr << ":";
+    for(unsigned i = 0; (i < words_per_line) && (job.state < words); i++, job.state++, addr += 4)
+      cout << " " << *reinterpret_cast<volatile uint32_t *>(addr);
+    cout << poorman::endl;
+    return job.state < words;
+  }
+};
+
+struct trace_log
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "log";
+  static constexpr const char * desc = "prints deferred trace log (binary mode: raw records for bin/log_decode.pl)";
+
+  void run(poorman::ostream<char> & cout) {
+#ifdef OPENMPTL_SIMULATION
+    Kernel::trace.print(cout);
+#else
+    cout << "use binary mode to dump records" << poorman::endl;
+#endif
+    cout << "dropped: " << poorman::dec << Kernel::trace.dropped() << poorman::hex << poorman::endl;
+  }
+
+  void run_binary(mptl::terminal_binary_frame & frame) {
+    /* max 8 records per request: fits into tx_fifo, even if fully escaped */
+    Kernel::trace.dump(frame.out, 8);
+  }
+};
+
+struct profile
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "prof";
+  static constexpr const char * desc = "prof [reset]: prints (or resets) profile statistics of kernel tasks";
+
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    if(std::strcmp(args[1], "reset") == 0)
+      Kernel::profiler::reset();
+    else
+      Kernel::profiler::dump(cout);
+  }
+};
+
+struct isr_stat
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "isr";
+  static constexpr const char * desc = "isr [reset]: prints (or resets) isr statistics (duration, entry jitter, budget overruns)";
+
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    if(std::strcmp(args[1], "reset") == 0)
+      Kernel::isr_trace::reset< Kernel::resources >();
+    else
+      Kernel::isr_trace::dump< Kernel::resources >(cout);
+  }
+};
+
+struct pool_stat
+: public mptl::terminal_hook
+{
+  static constexpr const char * cmd  = "pool";
+  static constexpr const char * desc = "pool [reset|eat]: prints (or resets) memory pool statistics, eat: allocate (leak) 1k buffer";
+
+  template<typename pool_type>
+  static void print(poorman::ostream<char> & cout, const char * name, pool_type const & pool) {
+    mptl::block_pool_statistics stat;
+    pool.get_statistics(stat);
+    cout << name << poorman::dec
+         << " block="  << pool_type::block_size
+         << " size="   << stat.size
+         << " used="   << stat.used
+         << " peak="   << stat.peak
+         << " total="  << stat.total
+         << " failed=" << stat.failed
+         << poorman::hex << poorman::endl;
+  }
+
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    if(std::strcmp(args[1], "reset") == 0) {
+      Kernel::buffer_pool.reset_counter();
+#ifndef OPENMPTL_USE_BOOST
+      screen_item_pool.reset_counter();
+#endif
+      return;
+    }
+    if(std::strcmp(args[1], "eat") == 0) {
+      void * buf = Kernel::buffer_pool.allocate();
+      if(buf)
+        std::memset(buf, 42, Kernel::buffer_pool_type::block_size);
+      else
+        cout << "buffer pool exhausted" << poorman::endl;
+    }
+    print(cout, "buffer:", Kernel::buffer_pool);
+#ifndef OPENMPTL_USE_BOOST
+    print(cout, "screen:", screen_item_pool);
+#endif
+  }
 };
 
 struct nrf_test
@@ -59,7 +250,14 @@ struct nrf_test
 
 using commands = mptl::terminal_hook_list<
   cpuid,
-  heap_eater,
+  fifo_stat,
+  peek,
+  poke,
+  memdump,
+  trace_log,
+  profile,
+  isr_stat,
+  pool_stat,
   nrf_test
   >;
 
@@ -18,27 +18,22 @@
  *
  */
 
-#include "timepoint.hpp"
 #include "time.hpp"
 #include "kernel.hpp"
 
-std::atomic<systick_t> SystemTime::systick_count;
-
-void SystemTime::systick_isr(void) {
-  systick_count.fetch_add(1, std::memory_order_relaxed);
-}
-
 void SystemTime::rtc_isr() {
   Kernel::rtc::clear_second_flag();
   Kernel::led::toggle();
+  Kernel::event_queue.emplace(Kernel::time::get_systick(),
+                              EventRecord::Type::rtc_second,
+                              Kernel::rtc::get_counter());
 }
 
 void SystemTime::nanosleep(unsigned int ns) {
-  TimePoint end;
-  end.set();
-  end.add_ns(ns);
-  TimePoint now;
-  now.set();
-  while(now < end)
-    now.set();
+  using clock = Kernel::time::clock;
+  /* round up to the next counter cycle */
+  auto end = clock::now()
+    + std::chrono::duration_cast< clock::duration >(std::chrono::nanoseconds(ns))
+    + clock::duration(1);
+  while(clock::now() < end);
 }
@@ -23,18 +23,15 @@
 
 #include <arch/systick.hpp>
 #include <arch/rtc.hpp>
+#include <arch/clock.hpp>
 #include <typelist.hpp>
 #include <freq.hpp>
-#include <atomic>
 
 typedef unsigned int systick_t;
 
 class SystemTime
 {
 protected:
-  static std::atomic<systick_t> systick_count;
-
-  static void systick_isr(void);
   static void rtc_isr(void);
 
 public:
@@ -52,11 +49,20 @@ public:
   using rtc     = _rtc;
   using systick = _systick;
 
+  /* tickless time base: systick is reprogrammed to wake up the core
+   * only when the next task is due (see Kernel::run()) */
+  using tickless = mptl::systick_tickless< systick >;
+
+  /* high resolution clock (std::chrono compatible, systick counter resolution) */
+  using clock = mptl::clock< tickless >;
+
   static constexpr mptl::freq_t rtc_freq = mptl::hz(1);  /* 1sec signal period */
 
   using resources = mptl::typelist<
-    mptl::irq_handler< typename systick::irq,    systick_isr >,
+    mptl::irq_handler< typename systick::irq,    tickless::isr >,
     mptl::irq_handler< typename rtc::irq_global, rtc_isr     >,
+    mptl::irq_priority< typename systick::irq,    2 >,
+    mptl::irq_priority< typename rtc::irq_global, 3 >,
     typename systick::resources,
     typename rtc::resources
   >;
@@ -78,7 +84,7 @@ public:
   }
 
   static systick_t get_systick() {
-    return systick_count.load(std::memory_order_relaxed);
+    return tickless::get_tick();
   }
 };
 
@@ -20,29 +20,63 @@
 
 #include <arch/core.hpp>
 #include <terminal.hpp>
-#include <simulation.hpp>
+#include <scheduler.hpp>
 #include "terminal_hooks.hpp"
 #include "kernel.hpp"
 
 Kernel::terminal_type Kernel::terminal;
+/* hot data accessed by systick_isr(): zero wait state CCM */
+Kernel::timer_wheel_type Kernel::timers __ccm_bss;
+
+static Kernel::timer_wheel_type::timer blink_timer __ccm_bss;
 
 void Kernel::systick_isr() {
-  static constexpr int toggle_interval = systick::freq / 2;  /* 0.5 seconds interval */
-  static int systick_count = toggle_interval;
+  time_base::isr();
+  timers.advance(time_base::get_tick());
+}
 
-  systick_count--;
-  if(systick_count == 0) {
-    systick_count = toggle_interval;
+/*
+ * poll terminal (runs whenever input is available). Steps of a
+ * resumable hook (e.g. "dump") only run while tx_fifo has room for
+ * them (see terminal::pending()): lower priority tasks are not
+ * starved, and the tx interrupt wakes us up again.
+ */
+struct terminal_task : mptl::scheduler_task<>
+{
+  static bool pending(void) { return Kernel::terminal.pending(); }
+  static void run(void) { Kernel::terminal.process_input< terminal_hooks::commands >(); }
+};
 
+/* toggle leds, woken up by blink_timer */
+struct blink_task : mptl::scheduler_task<>
+{
+  static void run(void) {
     /* Demonstrate the impact of the active_state configuration (in
      * kernel.hpp, typedef led_blue): faking active_state::low for
      * Kernel::led_blue<> has the effect of green/blue leds toggling
      * alternately.
      */
-    led_green::toggle();
-    led_blue::toggle();
+    Kernel::led_green::toggle();
+    Kernel::led_blue::toggle();
   }
-}
+};
+
+/* tasks in priority order (see mptl::scheduler<>) */
+using scheduler = mptl::scheduler<
+  Kernel::get_systick,
+  terminal_task,
+  blink_task
+  >;
+
+/* tickless idle: wake up on the next task or timer expiry */
+struct idle_time_base
+{
+  static void sleep(unsigned ticks) {
+    Kernel::time_base::sleep(Kernel::timers.ticks_until_next(ticks));
+    /* catch up with the ticks compensated by time_base::sleep() */
+    Kernel::timers.advance(Kernel::time_base::get_tick());
+  }
+};
 
 void Kernel::init(void)
 {
@@ -63,6 +97,8 @@ void Kernel::init(void)
   usart::set_baudrate(115200);
 #endif
 
+  timers.reset(get_systick());
+
   /* finally start systick */
   systick::enable();
   systick::enable_interrupt();
@@ -74,11 +110,9 @@ void Kernel::run(void)
   terminal.open();
   terminal.tx_stream << "\r\n\r\nWelcome to OpenMPTL terminal console!\r\n# " << poorman::flush;
 
-  while(1)
-  {
-    /* poll terminal */
-    terminal.process_input< terminal_hooks::commands >();
+  /* toggle leds in 0.5 seconds interval */
+  timers.start(blink_timer, systick::freq / 2, scheduler::notify< blink_task >, systick::freq / 2);
 
-    SIM_RELAX; // sleep a bit (don't eat up all cpu power)
-  }
+  /* run tasks, sleep (tickless) when idle */
+  scheduler::run< idle_time_base >();
 }
@@ -30,6 +30,7 @@
 #include <arch/usart.hpp>
 #include <arch/usart_stream.hpp>
 #include <terminal.hpp>
+#include <timer_wheel.hpp>
 #include <typelist.hpp>
 #include <compiler.h>
 
@@ -49,6 +50,10 @@ struct Kernel
     mptl::systick_clock::external< sysclk, mptl::khz(1) >
     >;
 
+  /* tickless time base: systick is reprogrammed to wake up the core
+   * only when the next task is due (see Kernel::run()) */
+  using time_base = mptl::systick_tickless< systick >;
+
   /* Note that setting gpio_rx_type (and gpio_tx_type respectively)
    * template parameter implicitely adds the correct mptl::gpio<>
    * configuration traits to usart::resources. This means that by
@@ -74,17 +79,29 @@ struct Kernel
   using led_green     = mptl::gpio_led< 'D', 12 >;
   using led_orange    = mptl::gpio_led< 'D', 13 >;
   using led_red       = mptl::gpio_led< 'D', 14 >;
-  /* fake active_state on led_blue (refer to Kernel::systick_isr() definition in kernel.cpp) */
+  /* fake active_state on led_blue (refer to blink_task definition in kernel.cpp) */
   using led_blue      = mptl::gpio_led< 'D', 15, mptl::gpio_active_state::low >;
 
   /* our static terminal (bound to usart_irq_stream<usart_device>) */
   static terminal_type terminal;
 
+  /* software timers, advanced by systick_isr() (placed in CCM, see kernel.cpp) */
+  using timer_wheel_type = mptl::timer_wheel<>;
+  static timer_wheel_type timers;
+
+  /* number of systick ticks since startup (time base for Kernel::run() scheduler) */
+  static unsigned get_systick(void) {
+    return time_base::get_tick();
+  }
+
   /* Reset exception: triggered on system startup (system entry point). */
   static void __naked reset_isr(void);
 
-  /* Execute the systick isr in RAM, which makes it faster, with predictive execution time */
-  static void systick_isr(void) __attribute__ ((long_call, section (".ram_functions")));
+  /* Execute the systick isr from RAM (no flash wait states). Only code
+   * inlined into it runs from RAM: out-of-line callees (e.g. the
+   * timer callbacks called by timers.advance()) still run from flash.
+   */
+  static void systick_isr(void) __ram_function;
 
   static void null_isr(void)  { }
   static void warn_isr(void)  { Kernel::led_orange::on(); }
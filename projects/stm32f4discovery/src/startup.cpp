@@ -25,21 +25,24 @@
 
 extern const uint32_t _stack_top;  /* provided by linker script */
 
+/* Build the vector table:
+ * - use irq handler from irq_handler<> traits in Kernel::resources
+ * - use Kernel::error_isr as default isr
+ */
+using vector_table = mptl::vector_table<&_stack_top, Kernel::resources, Kernel::error_isr>;
+const auto isr_vector __attribute__((used,section(".isr_vector"))) = vector_table::value;
+
 /* Reset exception: triggered on system startup (system entry point). */
 void Kernel::reset_isr(void) {
   mptl::core::startup< sysclk, early_cfg >();
 
+  /* zero wait state vector fetch: use the (initialized) RAM copy of the vector table */
+  vector_table::relocate();
+
   Kernel::init();
   Kernel::run();
 }
 
-/* Build the vector table:
- * - use irq handler from irq_handler<> traits in Kernel::resources
- * - use Kernel::error_isr as default isr
- */
-using vector_table = mptl::vector_table<&_stack_top, Kernel::resources, Kernel::error_isr>;
-const auto isr_vector __attribute__((used,section(".isr_vector"))) = vector_table::value;
-
 
 #ifdef OPENMPTL_SIMULATION
 
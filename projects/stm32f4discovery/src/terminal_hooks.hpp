@@ -43,10 +43,15 @@ struct baudrate
 : public mptl::terminal_hook
 {
   static constexpr const char * cmd  = "baudrate";
-  static constexpr const char * desc = "set the terminal baudrate to 460.8 KBps";
-  void run(poorman::ostream<char> &) {
+  static constexpr const char * desc = "baudrate [rate]: set the terminal baudrate (default: 460.8 KBps)";
+  void run(poorman::ostream<char> & cout, mptl::terminal_args const & args) {
+    unsigned rate = 460800;
+    if((args.size() > 1) && (!args.get_int(1, rate) || (rate == 0))) {
+      cout << "usage: baudrate [rate]" << poorman::endl;
+      return;
+    }
     Kernel::terminal.close();
-    Kernel::usart::set_baudrate(460800);
+    Kernel::usart::set_baudrate(rate);
     Kernel::terminal.open();
   }
 };
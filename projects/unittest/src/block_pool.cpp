@@ -0,0 +1,151 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <block_pool.hpp>
+#include <iostream>
+#include <list>
+#include <cstdint>
+#include <cassert>
+
+using namespace mptl;
+
+using pool_type = block_pool< 10, 4 >;
+static pool_type pool;
+
+static_assert(pool_type::capacity == 4, "capacity");
+static_assert(pool_type::block_size % alignof(std::max_align_t) == 0, "block_size");
+static_assert(block_pool< 3, 1, 1 >::block_size == sizeof(void *), "block_size (free list link)");
+
+using list_pool_type = block_pool< 4 * sizeof(void *), 8 >;
+static list_pool_type list_pool;
+
+using small_pool_type = block_pool< sizeof(uint32_t), 2 >;
+static small_pool_type small_pool;
+
+/* exhaustion handler returning nullptr (not suitable for STL containers) */
+static unsigned exhausted_count;
+struct count_exhausted {
+  static void exhausted(void) { exhausted_count++; }
+};
+
+static void check_stat(pool_type const & p, unsigned used, unsigned peak, unsigned total, unsigned failed) {
+  block_pool_statistics stat;
+  p.get_statistics(stat);
+  assert(stat.size == 4);
+  assert(stat.used == used);
+  assert(stat.peak == peak);
+  assert(stat.total == total);
+  assert(stat.failed == failed);
+  assert(p.available() == 4 - used);
+}
+
+int main()
+{
+  std::cout << "*** unittest block_pool ***" << std::endl;
+
+  check_stat(pool, 0, 0, 0, 0);
+
+  /* allocate all blocks: distinct, aligned, owned by pool */
+  void * b[4];
+  for(unsigned i = 0; i < 4; i++) {
+    b[i] = pool.allocate();
+    assert(b[i] != nullptr);
+    assert(reinterpret_cast<uintptr_t>(b[i]) % alignof(std::max_align_t) == 0);
+    assert(pool.owns(b[i]));
+    for(unsigned j = 0; j < i; j++)
+      assert(b[i] != b[j]);
+  }
+  check_stat(pool, 4, 4, 4, 0);
+
+  /* exhausted */
+  assert(pool.allocate() == nullptr);
+  assert(pool.allocate() == nullptr);
+  check_stat(pool, 4, 4, 4, 2);
+
+  int local;
+  assert(!pool.owns(&local));
+
+  /* free and re-allocate (LIFO) */
+  pool.deallocate(b[1]);
+  pool.deallocate(b[3]);
+  pool.deallocate(nullptr);
+  check_stat(pool, 2, 4, 4, 2);
+  assert(pool.allocate() == b[3]);
+  assert(pool.allocate() == b[1]);
+  assert(pool.allocate() == nullptr);
+  check_stat(pool, 4, 4, 6, 3);
+
+  /* reset counter: peak follows current usage */
+  for(unsigned i = 0; i < 4; i++)
+    pool.deallocate(b[i]);
+  pool.reset_counter();
+  check_stat(pool, 0, 0, 0, 0);
+  void * p = pool.allocate();
+  check_stat(pool, 1, 1, 1, 0);
+  pool.deallocate(p);
+
+  /* STL allocator adapter (std::list nodes: two links and value) */
+  {
+    using list_type = std::list< int, pool_allocator< int, list_pool_type, &list_pool > >;
+    list_type l;
+    for(int i = 0; i < 8; i++)
+      l.push_back(i);
+    block_pool_statistics stat;
+    list_pool.get_statistics(stat);
+    assert(stat.used == 8 && stat.peak == 8 && stat.failed == 0);
+    l.remove(3);
+    l.remove(5);
+    l.push_front(42);
+    l.push_front(43);
+    assert(l.size() == 8);
+    assert(l.front() == 43);
+    list_pool.get_statistics(stat);
+    assert(stat.used == 8 && stat.peak == 8 && stat.total == 10);
+  }
+  assert(list_pool.available() == 8);
+
+  /* adapter exhaustion: handler is called */
+  pool_allocator< uint32_t, small_pool_type, &small_pool, count_exhausted > alloc;
+  uint32_t * a0 = alloc.allocate(1);
+  uint32_t * a1 = alloc.allocate(1);
+  assert(a0 && a1 && (a0 != a1));
+  assert(exhausted_count == 0);
+  assert(alloc.allocate(1) == nullptr);
+  assert(exhausted_count == 1);
+  alloc.deallocate(a0, 1);
+  assert(alloc.allocate(2) == nullptr);  /* arrays are not supported */
+  assert(exhausted_count == 2);
+  assert(alloc.allocate(1) == a0);
+  alloc.deallocate(a0, 1);
+  alloc.deallocate(a1, 1);
+
+  /* rebound allocators compare equal (stateless) */
+  pool_allocator< char, small_pool_type, &small_pool, count_exhausted > alloc_char(alloc);
+  assert(alloc_char == alloc);
+  assert(!(alloc_char != alloc));
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "object does not fit into block_pool block_size"
+  pool_allocator< char[64], small_pool_type, &small_pool > alloc_big;
+  alloc_big.allocate(1);
+#endif
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <arch/rcc.hpp>
+#include <arch/clock.hpp>
+#include <iostream>
+#include <cassert>
+
+std::ostream & mptl::sim::regdump_ostream = std::cout;
+
+using namespace mptl;
+
+using sysclk       = system_clock_hse< mhz(168) >;
+using systick_type = systick< systick_clock::external< sysclk, khz(1) > >;
+using time_base    = systick_tickless< systick_type >;
+using clock_type   = mptl::clock< time_base >;
+
+static_assert(systick_type::counter_freq == mhz(21), "counter_freq");
+static_assert(time_base::tick_cycles == 21001, "tick_cycles");
+static_assert(clock_type::is_steady, "is_steady");
+static_assert(std::is_same< clock_type::duration::period, std::ratio< 1, 21000000 > >::value, "period");
+
+int main()
+{
+  std::cout << "*** unittest clock ***" << std::endl;
+
+  /* start of tick */
+  SCB::STCVR::store(time_base::reload_value);
+  assert(clock_type::now_cycles() == 0);
+
+  /* counter counts down */
+  SCB::STCVR::store(time_base::reload_value - 2100);
+  assert(clock_type::now_cycles() == 2100);
+  assert(clock_type::now_ns() == 100000);
+
+  time_base::isr();
+  time_base::isr();
+  assert(time_base::get_tick() == 2);
+  assert(clock_type::now_cycles() == 2 * 21001 + 2100);
+
+  /* counter reloaded, systick isr pending (not yet executed) */
+  SCB::ICSR::PENDSTSET::set();
+  assert(clock_type::now_cycles() == 3 * 21001 + 2100);
+  SCB::ICSR::PENDSTSET::clear();
+
+  /* 64bit tick count: lower 32 bits wrap */
+  time_base::sim_set_tick64((1ull << 32) - 3);
+  assert(time_base::get_tick64() == (1ull << 32) - 3);
+  for(unsigned i = time_base::get_tick(); i != 0; i++)
+    time_base::isr();
+  assert(time_base::get_tick() == 0);
+  assert(time_base::get_tick64() == (1ull << 32));
+  SCB::STCVR::store(time_base::reload_value);
+  assert(clock_type::now_cycles() == (1ull << 32) * 21001);
+
+  /* std::chrono: no overflow after 2^32 ticks (~50 days) */
+  auto t = clock_type::now();
+  auto s = std::chrono::duration_cast< std::chrono::seconds >(t.time_since_epoch()).count();
+  assert(s == (int64_t)((1ull << 32) * 21001 / 21000000));
+  assert((clock_type::now() - t).count() == 0);
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <arch/critical_section.hpp>
+#include <iostream>
+#include <cassert>
+
+using namespace mptl;
+
+using resources = typelist<
+  irq_priority< irq::usart<2>,     2 >,
+  irq_priority< irq::usart<2>,     2 >,  /* identical declaration is fine */
+  irq_priority< irq::dma1_stream5, 3 >,
+  irq_priority< irq::adc,          5 >,
+  irq_priority< irq::systick,      1 >
+  >;
+
+using prio_group = irq_priority_grouping< 2 >;
+using group_resources = typelist<
+  prio_group,
+  prio_group::irq_priority< irq::usart<2>, 1, 3 >,
+  prio_group::irq_priority< irq::adc,      2, 0 >
+  >;
+
+using usart_lock   = critical_section< resources, irq::usart<2>, irq::dma1_stream5 >;
+using adc_lock     = critical_section< resources, irq::adc >;
+using tim2_lock    = critical_section< resources, irq::adc, irq::tim2 >;  /* tim2: no irq_priority<> (priority 0) */
+using group_lock   = critical_section< group_resources, irq::usart<2>, irq::adc >;
+
+static_assert(usart_lock::ceiling == 0x20 && usart_lock::use_basepri, "usart_lock");
+static_assert(adc_lock::ceiling   == 0x50 && adc_lock::use_basepri,   "adc_lock");
+static_assert(tim2_lock::ceiling  == 0x00 && !tim2_lock::use_basepri, "tim2_lock");
+static_assert(group_lock::ceiling == 0x40, "group_lock");  /* subpriority is ignored */
+
+using sim_core = mpl::critical_section_core<>;
+
+int main()
+{
+  std::cout << "*** unittest critical_section ***" << std::endl;
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: list contains more than one element
+  using conflict_resources = typelist< irq_priority< irq::adc, 5 >, irq_priority< irq::adc, 6 > >;
+  critical_section< conflict_resources, irq::adc > lock;
+#endif
+
+  assert(sim_core::get_basepri() == 0);
+  {
+    adc_lock lock;
+    assert(sim_core::get_basepri() == 0x50);
+    {
+      usart_lock nested;
+      assert(sim_core::get_basepri() == 0x20);
+      {
+        adc_lock inner;  /* never lowers BASEPRI */
+        assert(sim_core::get_basepri() == 0x20);
+      }
+      assert(sim_core::get_basepri() == 0x20);
+    }
+    assert(sim_core::get_basepri() == 0x50);
+    assert(sim_core::get_primask() == 0);
+  }
+  assert(sim_core::get_basepri() == 0);
+
+  /* ceiling 0: disable all irq's */
+  {
+    tim2_lock lock;
+    assert(sim_core::get_primask() == 1);
+    assert(sim_core::get_basepri() == 0);
+    {
+      tim2_lock nested;
+      assert(sim_core::get_primask() == 1);
+    }
+    assert(sim_core::get_primask() == 1);
+  }
+  assert(sim_core::get_primask() == 0);
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <crt.hpp>
+#include <profiler.hpp>
+#include <iostream>
+#include <cassert>
+
+/* simulated memory: flash (load image) and two ram regions (e.g. RAM and CCM on f4) */
+static constexpr unsigned ram_words = 128 * 1024 / 4;
+static constexpr unsigned ccm_words =  16 * 1024 / 4;
+
+static uint32_t flash[ram_words + ccm_words];
+static uint32_t ram[ram_words];
+static uint32_t ccm[ccm_words];
+
+/* naive loop, as in crt.hpp before */
+static void naive_init(uint32_t * dst, const uint32_t * src, const uint32_t * end) {
+  while(dst < end)
+    *(dst++) = *(src++);
+}
+
+/* print words and loop iterations for a region of n words, returns crt loop iterations */
+static unsigned report_region(const char * name, unsigned index, unsigned n) {
+  std::cout << "boot benchmark: " << name << " region " << index << ": words=" << n
+            << " naive_iterations=" << n
+            << " crt_bursts=" << (n >> 2) << " crt_tail=" << (n & 3) << std::endl;
+  return (n >> 2) + (n & 3);
+}
+
+static void fill(uint32_t * p, unsigned n, uint32_t value) {
+  for(unsigned i = 0; i < n; i++)
+    p[i] = value + i;
+}
+
+int main()
+{
+  std::cout << "*** unittest crt ***" << std::endl;
+
+  /* all sizes (tail handling), surrounding words untouched */
+  for(unsigned n = 0; n < 40; n++) {
+    fill(flash, 64, 0x1000);
+    fill(ram, 64, 0xdead0000);
+    assert(crt::copy_words(&ram[1], flash, &ram[1 + n]) == n);
+    assert(ram[0] == 0xdead0000);
+    for(unsigned i = 0; i < n; i++)
+      assert(ram[1 + i] == 0x1000 + i);
+    assert(ram[1 + n] == 0xdead0000 + 1 + n);
+
+    fill(ram, 64, 0xdead0000);
+    assert(crt::zero_words(&ram[1], &ram[1 + n]) == n);
+    assert(ram[0] == 0xdead0000);
+    for(unsigned i = 0; i < n; i++)
+      assert(ram[1 + i] == 0);
+    assert(ram[1 + n] == 0xdead0000 + 1 + n);
+  }
+
+  /* region tables: .data, .ram_functions and .ccm_data (load images consecutive in flash), .bss and .ccm_bss */
+  const unsigned data_words = 1000;
+  const unsigned ram_functions_words = 100;
+  const unsigned ccm_data_words = 333;
+  const crt::data_region data_table[] = {
+    { flash,                                    ram,              ram + data_words - ram_functions_words },
+    { flash + data_words - ram_functions_words, ram + data_words - ram_functions_words, ram + data_words },
+    { flash + data_words,                       ccm,              ccm + ccm_data_words },
+    { ram,                                      ram,              ram },  /* executed in place (empty) */
+  };
+  const crt::bss_region bss_table[] = {
+    { ram + data_words,     ram + ram_words },
+    { ccm + ccm_data_words, ccm + ccm_words },
+  };
+
+  fill(flash, ram_words + ccm_words, 0x42000000);
+  fill(ram, ram_words, 0xdead0000);
+  fill(ccm, ccm_words, 0xdead0000);
+
+  assert(crt::check_regions(data_table, data_table + 4, bss_table, bss_table + 2));
+
+  assert(crt::init_data_regions(data_table, data_table + 4) == data_words + ccm_data_words);
+  assert(crt::init_bss_regions(bss_table, bss_table + 2) == ram_words + ccm_words - data_words - ccm_data_words);
+  for(unsigned i = 0; i < ram_words; i++)
+    assert(ram[i] == (i < data_words ? 0x42000000 + i : 0));
+  for(unsigned i = 0; i < ccm_words; i++)
+    assert(ccm[i] == (i < ccm_data_words ? 0x42000000 + data_words + i : 0));
+
+  /* broken region tables */
+  {
+    const crt::data_region data_overlap[] = {
+      { flash,      ram,      ram + 10 },
+      { flash + 10, ram + 8,  ram + 20 },  /* overlaps previous */
+    };
+    assert(!crt::check_regions(data_overlap, data_overlap + 2, bss_table, bss_table));
+
+    const crt::bss_region bss_overlap[] = {
+      { ram + 10, ram + 20 },
+      { ram + 19, ram + 30 },
+    };
+    assert(!crt::check_regions(data_table, data_table, bss_overlap, bss_overlap + 2));
+    assert(!crt::check_regions(data_overlap + 1, data_overlap + 2, bss_overlap, bss_overlap + 1));  /* data vs. bss */
+    assert(crt::check_regions(data_overlap, data_overlap + 1, bss_overlap, bss_overlap + 1));       /* adjacent */
+
+    const crt::data_region data_reversed[] = { { flash, ram + 10, ram } };
+    assert(!crt::check_regions(data_reversed, data_reversed + 1, bss_table, bss_table));
+
+    const crt::data_region lma_overlap[] = { { ram + 5, ram, ram + 10 } };  /* load image overwritten */
+    assert(!crt::check_regions(lma_overlap, lma_overlap + 1, bss_table, bss_table));
+
+    uint32_t * unaligned = reinterpret_cast<uint32_t *>(reinterpret_cast<uintptr_t>(ram) + 2);
+    const crt::bss_region bss_unaligned[] = { { unaligned, unaligned + 4 } };
+    assert(!crt::check_regions(data_table, data_table, bss_unaligned, bss_unaligned + 1));
+
+    const crt::bss_region bss_empty[] = { { ram, ram }, { ram, ram + 4 } };  /* empty regions never overlap */
+    assert(crt::check_regions(data_table, data_table, bss_empty, bss_empty + 2));
+  }
+
+  /* linker region tables (not available in simulation) */
+  assert(crt::check_regions());
+
+  /* empty tables */
+  assert(crt::init_data_regions(data_table, data_table) == 0);
+  assert(crt::init_bss_regions(bss_table, bss_table) == 0);
+
+  /*
+   * boot benchmark: per region words and loop iterations (naive: one
+   * iteration per word, crt: one iteration per four-word burst plus
+   * 0..3 tail words). These numbers do not depend on the host.
+   */
+  unsigned total_words = 0, total_crt = 0;
+  for(const crt::data_region * r = data_table; r < data_table + 4; r++) {
+    unsigned n = (r->start == r->lma) ? 0 : r->end - r->start;  /* executed in place: not copied */
+    total_crt += report_region("data", r - data_table, n);
+    total_words += n;
+  }
+  for(const crt::bss_region * r = bss_table; r < bss_table + 2; r++) {
+    unsigned n = r->end - r->start;
+    total_crt += report_region("bss", r - bss_table, n);
+    total_words += n;
+  }
+  assert(total_words == ram_words + ccm_words);
+  assert(crt::init_data_regions(data_table, data_table + 4) + crt::init_bss_regions(bss_table, bss_table + 2) == total_words);
+  std::cout << "boot benchmark: total words=" << total_words << " naive_iterations=" << total_words
+            << " crt_iterations=" << total_crt << std::endl;
+
+  /* host wall clock time (simulation only, not representative for the target) */
+  const unsigned runs = 16;
+  uint32_t t_naive = 0, t_crt = 0;
+  for(unsigned i = 0; i < runs; i++) {
+    uint32_t start = mptl::profiler_clock::now();
+    for(const crt::data_region * r = data_table; r < data_table + 4; r++) {
+      if(r->start != r->lma)
+        naive_init(r->start, r->lma, r->end);
+    }
+    for(const crt::bss_region * r = bss_table; r < bss_table + 2; r++) {
+      for(uint32_t * p = r->start; p < r->end; p++)
+        *p = 0;
+    }
+    t_naive += mptl::profiler_clock::now() - start;
+
+    start = mptl::profiler_clock::now();
+    crt::init_data_regions(data_table, data_table + 4);
+    crt::init_bss_regions(bss_table, bss_table + 2);
+    t_crt += mptl::profiler_clock::now() - start;
+  }
+  std::cout << "boot benchmark: host time (mean of " << runs << " runs): "
+            << "naive=" << t_naive / runs << " crt=" << t_crt / runs
+            << " [host " << mptl::profiler_clock::unit << "]" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <deferred_log.hpp>
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+using namespace mptl;
+
+/** poorman::static_ostream<> writing to std::string */
+struct string_ostream : public poorman::static_ostream<string_ostream, char>
+{
+  std::string str;
+
+  string_ostream & put(char c) { str += c; return *this; }
+  string_ostream & puts(const char * s) { str += s; return *this; }
+  string_ostream & write(const char * s, unsigned int count) { str.append(s, count); return *this; }
+  string_ostream & flush() { return *this; }
+  string_ostream & endl() { str += '\n'; return *this; }
+};
+
+enum class color : uint8_t { red = 1, green = 2 };
+
+using log_type = deferred_log<4, 4>;
+static log_type trace;
+
+int main()
+{
+  std::cout << "*** unittest deferred_log ***" << std::endl;
+
+  string_ostream os;
+  static_assert(log_type::dump_record_size == 20, "dump_record_size");
+
+  trace.reset();
+  assert(trace.dropped() == 0);
+
+  MPTL_LOG(trace, "hello");
+  MPTL_LOG(trace, "u=%u d=%d x=%x", 42u, -5, 0xbeefu);
+  MPTL_LOG(trace, "[%5u] [%05d] [%08x] [%c] 100%%", 7, -42, 0xabcdu, 'z');
+  MPTL_LOG(trace, "enum=%u missing=%u trailing %", color::green);
+  assert(trace.read_available() == 4);
+
+  /* log full: record is dropped */
+  MPTL_LOG(trace, "dropped");
+  assert(trace.dropped() == 1);
+
+  /* print (format strings are accessible in simulation) */
+  assert(trace.print(os, 2) == 2);
+  assert(os.str == "hello\nu=42 d=-5 x=beef\n");
+  os.str.clear();
+  assert(trace.print(os) == 2);
+  assert(os.str == "[    7] [-0042] [0000abcd] [z] 100%\nenum=2 missing=0 trailing \n");
+  assert(trace.read_available() == 0);
+
+  /* formatting state of stream is restored */
+  os.str.clear();
+  os << 42;
+  assert(os.str == "0000002a");
+
+  /* binary dump: <id:u32> <arg:u32> * max_args */
+  const char * fmt = "dump %u %u";
+  trace.write(fmt, 1, 2);
+  os.str.clear();
+  assert(trace.dump(os) == 1);
+  assert(os.str.size() == log_type::dump_record_size);
+  uint32_t raw[5];
+  memcpy(raw, os.str.data(), sizeof(raw));
+  assert(raw[0] == (uint32_t)(uintptr_t)fmt);
+  assert(raw[1] == 1 && raw[2] == 2 && raw[3] == 0 && raw[4] == 0);
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "too many arguments for deferred_log"
+  MPTL_LOG(trace, "%u %u %u %u %u", 1, 2, 3, 4, 5);
+#endif
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "deferred_log arguments must fit into 32 bits"
+  MPTL_LOG(trace, "%llu", 1ull);
+#endif
+
+  return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <fifo.hpp>
+#include <iostream>
+#include <cassert>
+
+using namespace mptl;
+
+static counted_ring_buffer<char, 8> rb;
+
+/* mock of a gpio_output<> */
+struct rts_line {
+  static bool state;
+  static void (*on_enable)(void);  /* producer preempting the consumer before RTS is asserted */
+  static void enable(void)  { if(on_enable) on_enable(); state = true; }
+  static void disable(void) { state = false; }
+  static bool active(void)  { return state; }
+};
+bool rts_line::state;
+void (*rts_line::on_enable)(void);
+
+static flow_controlled_fifo< ring_buffer<char, 8>, rts_line, 5, 2 > fc;
+
+static void test_flow_control(void)
+{
+  char c;
+
+  rts_line::state = false;
+  fc.reset();
+  assert(fc.rts_active());
+
+  /* deassert RTS on high watermark */
+  assert(fc.pushs("abcd"));
+  assert(fc.rts_active());
+  assert(fc.push('e'));
+  assert(!fc.rts_active());
+  assert(fc.pushs("fg"));
+  assert(!fc.rts_active());
+
+  /* assert RTS again on low watermark */
+  assert(fc.pop(c) && c == 'a');
+  assert(fc.pop(c) && c == 'b');
+  assert(fc.pop(c) && c == 'c');
+  assert(fc.pop(c) && c == 'd');
+  assert(!fc.rts_active());
+  assert(fc.pop(c) && c == 'e');
+  assert(fc.rts_active());
+
+  /* consume() also checks the low watermark */
+  assert(fc.pushs("hijk"));
+  assert(!fc.rts_active());
+  fc.consume(4);
+  assert(fc.rts_active());
+  assert(fc.read_available() == 2);
+
+  /* producer preempts the consumer while asserting RTS */
+  fc.consume(1);
+  rts_line::on_enable = [](void) { rts_line::on_enable = nullptr; assert(fc.pushs("lmnop")); };
+  fc.consume(1);
+  assert(fc.read_available() == 5);
+  assert(!fc.rts_active());
+}
+
+static flow_controlled_fifo< ring_buffer<char, 8>, rts_line, 3, 1 > fc_dma;
+
+static void test_flow_control_dma(void)
+{
+  fc_dma.reset();
+  assert(fc_dma.commit_write_index(2, 2) == 0);
+  assert(fc_dma.rts_active());
+  assert(fc_dma.commit_write_index(3, 1) == 0);
+  assert(!fc_dma.rts_active());
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "high_watermark leaves no room for half a buffer of unpublished DMA data"
+  fc.commit_write_index(0, 0);
+#endif
+}
+
+static ring_buffer<char, 8> dma_rb;
+
+static void test_commit_write_index(void)
+{
+  char c;
+  char * buf = dma_rb.data();
+
+  dma_rb.reset();
+  buf[0] = 'a'; buf[1] = 'b'; buf[2] = 'c';
+  assert(dma_rb.commit_write_index(3, 3) == 0);
+  assert(dma_rb.read_available() == 3);
+  assert(dma_rb.pop(c) && c == 'a');
+
+  /* overrun: the writer wraps around and overwrites "b" and "c". The
+   * consumer resyncs to the most recent 7 elements */
+  buf[3] = 'd'; buf[4] = 'e'; buf[5] = 'f'; buf[6] = 'g'; buf[7] = 'h';
+  buf[0] = 'i'; buf[1] = 'j';
+  assert(dma_rb.commit_write_index(2, 7) == 2);
+  assert(dma_rb.read_available() == 1);  /* read index not yet resynced */
+  const char * expected = "defghij";
+  while(dma_rb.pop(c))
+    assert(c == *expected++);
+  assert(*expected == 0);
+  assert(dma_rb.test_and_clear_overrun());
+  assert(!dma_rb.test_and_clear_overrun());
+
+  /* full lap: not visible from the index, passed as count */
+  assert(dma_rb.commit_write_index(4, 10) == 3);
+
+  /* overrun not yet handled by the consumer: all new elements are lost */
+  assert(dma_rb.commit_write_index(6, 2) == 2);
+  dma_rb.consume(3);  /* elements discarded by the overrun: resync only */
+  assert(dma_rb.read_available() == 7);
+  assert(dma_rb.peek(6) != nullptr);
+  assert(dma_rb.peek(7) == nullptr);
+  assert(dma_rb.test_and_clear_overrun());
+}
+
+static counted_ring_buffer<char, 8> crb;
+
+static void test_counted_slot_access(void)
+{
+  char c;
+  char * slot;
+
+  crb.reset();
+  slot = crb.prepare_write();
+  assert(slot != nullptr);
+  *slot = 'a';
+  crb.commit_write();
+  assert(crb.get_total() == 1);
+  assert(crb.get_peak() == 1);
+
+  crb.data()[1] = 'b'; crb.data()[2] = 'c'; crb.data()[3] = 'd';
+  assert(crb.commit_write_index(4, 3) == 0);
+  assert(crb.get_total() == 4);
+  assert(crb.get_peak() == 4);
+  assert(crb.get_max_burst() == 4);
+  while(crb.pop(c));
+
+  /* full lap plus 2 elements: 3 elements lost */
+  assert(crb.commit_write_index(6, 10) == 3);
+  assert(crb.get_overrun() == 3);
+  assert(crb.get_total() == 11);
+  assert(crb.get_peak() == 7);
+  while(crb.pop(c));
+
+  for(int i = 0; i < 7; i++) {
+    slot = crb.prepare_write();
+    assert(slot != nullptr);
+    crb.commit_write();
+  }
+  assert(crb.prepare_write() == nullptr);
+  assert(crb.get_overrun() == 4);
+  assert(crb.get_total() == 18);
+}
+
+int main()
+{
+  std::cout << "*** unittest fifo ***" << std::endl;
+
+  fifo_statistics stat = fifo_statistics();
+  char c;
+
+  rb.reset();
+  assert(rb.read_available() == 0);
+  assert(rb.write_available() == 7);
+
+  /* burst of 3, partially drained */
+  assert(rb.push('a'));
+  assert(rb.pushs("bc"));
+  assert(rb.read_available() == 3);
+  assert(rb.pop(c) && c == 'a');
+  assert(rb.push('d'));
+  assert(rb.get_max_burst() == 4);
+  assert(rb.get_peak() == 3);
+
+  /* drain completely: next push starts a new burst */
+  while(rb.pop(c));
+  assert(rb.get_underrun() == 1);
+  assert(rb.push('e'));
+  assert(rb.get_max_burst() == 4);
+
+  /* fill up to capacity, then overrun */
+  assert(rb.pushs("fghijk"));
+  assert(rb.write_available() == 0);
+  assert(rb.get_peak() == 7);
+  assert(rb.push('x') == false);
+  assert(rb.pushs("yz") == false);  /* string does not fit: writes nothing */
+  assert(rb.get_overrun() == 3);
+  assert(rb.get_total() == 11);
+
+  stat.update(rb);
+  assert(stat.size == 7);
+  assert(stat.level == 7);
+  assert(stat.max_burst == 7);
+  assert(stat.overrun == 3);
+  assert(stat.overrun_delta == 3);
+
+  /* wrap around */
+  assert(rb.pop(c) && c == 'e');
+  assert(rb.pop(c) && c == 'f');
+  assert(rb.pushs("lm"));
+  assert(rb.push('n') == false);
+
+  stat.update(rb);
+  assert(stat.overrun_delta == 1);
+
+  const char * expected = "ghijklm";
+  while(rb.pop(c))
+    assert(c == *expected++);
+  assert(*expected == 0);
+
+  rb.reset();
+  assert(rb.get_total() == 0);
+  assert(rb.get_peak() == 0);
+
+  test_flow_control();
+  test_flow_control_dma();
+  test_commit_write_index();
+  test_counted_slot_access();
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <arch/vector_table.hpp>
+#include <isr_trace.hpp>
+#include <iostream>
+#include <string>
+#include <cassert>
+
+using namespace mptl;
+
+/* fake clock, advanced by the isr's */
+static uint32_t fake_time;
+struct fake_clock {
+  static uint32_t now(void) { return fake_time; }
+};
+
+static unsigned int stack_top = 0;
+static int isr_test = 0;
+
+static void default_isr(void) { isr_test = 0; }
+static void reset_isr(void) { isr_test = -1; }
+static void isr_42(void) { isr_test = 42; fake_time += 100; }
+static void isr_43(void) { isr_test = 43; fake_time += 10; }
+
+using irq42 = irq_handler< irq_base<42>, isr_42 >;
+using irq43 = irq_handler< irq_base<43>, isr_43 >;
+
+using resource_list = mptl::typelist<
+  irq_handler< irq::reset, reset_isr >,
+  irq42,
+  irq43
+  >;
+
+using trace = isr_trace< fake_clock, 50 >;
+
+class string_ostream : public poorman::ostream<char>
+{
+public:
+  std::string str;
+  string_ostream & put(char c) { str += c; return *this; }
+  string_ostream & puts(const char* s) { str += s; return *this; }
+  string_ostream & write(const char* s, unsigned int count) { str.append(s, count); return *this; }
+  string_ostream & flush() { return *this; }
+  string_ostream & endl() { str += '\n'; return *this; }
+};
+
+int main()
+{
+  std::cout << "*** unittest isr_trace ***" << std::endl;
+
+  /* without isr_wrapper: plain isr's */
+  using vt_plain = vector_table<&stack_top, resource_list, default_isr>;
+  mptl::arm_cortex_vector_table<vt_plain::vt_size> plain_vector_table = vt_plain::value;
+  assert((unsigned long)plain_vector_table.isr_vector[vt_plain::irq_channel_offset + 42] == (unsigned long)isr_42);
+
+  using vt = vector_table<&stack_top, resource_list, default_isr, trace>;
+  mptl::arm_cortex_vector_table<vt::vt_size> arm_vector_table = vt::value;
+
+  /* reset and default isr are not wrapped */
+  assert((unsigned long)arm_vector_table.isr_vector[vt::irq_channel_offset + irq::reset::irqn] == (unsigned long)reset_isr);
+  assert((unsigned long)arm_vector_table.isr_vector[vt::irq_channel_offset + 41] == (unsigned long)default_isr);
+  assert((unsigned long)arm_vector_table.isr_vector[vt::irq_channel_offset + 42] != (unsigned long)isr_42);
+  assert((unsigned long)arm_vector_table.isr_vector[vt::irq_channel_offset + 42] ==
+         (unsigned long)trace::wrap< irq42 >::isr);
+
+  trace::reset< resource_list >();
+
+  /* irq 42: entries at t=1000, 1300, 1500 */
+  fake_time = 1000;
+  arm_vector_table.isr_vector[vt::irq_channel_offset + 42]();
+  assert(isr_test == 42);
+  fake_time = 1300;
+  arm_vector_table.isr_vector[vt::irq_channel_offset + 42]();
+  fake_time = 1500;
+  arm_vector_table.isr_vector[vt::irq_channel_offset + 42]();
+
+  isr_stats const & st = trace::stats< irq_base<42> >();
+  assert(st.duration.count == 3);
+  assert(st.duration.max == 100 && st.duration.total == 300);
+  assert(st.interval_min == 200 && st.interval_max == 300);
+  assert(st.jitter() == 100);
+  assert(st.overruns == 3);
+
+  /* irq 43: within budget */
+  arm_vector_table.isr_vector[vt::irq_channel_offset + 43]();
+  assert(isr_test == 43);
+  assert(trace::stats< irq_base<43> >().duration.count == 1);
+  assert(trace::stats< irq_base<43> >().overruns == 0);
+  assert(trace::stats< irq_base<43> >().jitter() == 0);
+
+  string_ostream out;
+  trace::dump< resource_list >(out, "cyc");
+  std::cout << out.str;
+  assert(out.str ==
+         "irq 42: n=3 min=100 mean=100 max=100 jitter=100 over=3 [cyc]\n"
+         "irq 43: n=1 min=10 mean=10 max=10 jitter=0 over=0 [cyc]\n");
+
+  trace::reset< resource_list >();
+  assert(st.duration.count == 0 && st.jitter() == 0);
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <message_queue.hpp>
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+
+using namespace mptl;
+
+struct event_record {
+  uint32_t timestamp;
+  uint16_t id;
+  uint16_t value;
+};
+
+static message_queue<event_record, 4> mq;
+
+int main()
+{
+  std::cout << "*** unittest message_queue ***" << std::endl;
+
+  event_record ev;
+  unsigned int sum;
+
+  mq.reset();
+  assert(mq.read_available() == 0);
+  assert(mq.write_available() == 4);
+
+  /* post and emplace up to capacity */
+  assert(mq.post(event_record{ 100, 1, 10 }));
+  assert(mq.emplace(200u, uint16_t(2), uint16_t(20)));
+  assert(mq.emplace(300u, uint16_t(3), uint16_t(30)));
+  assert(mq.post(event_record{ 400, 4, 40 }));
+  assert(mq.write_available() == 0);
+  assert(mq.emplace(500u, uint16_t(5), uint16_t(50)) == false);
+
+  /* single message */
+  assert(mq.drain([&](event_record const & e) { ev = e; }, 1) == 1);
+  assert(ev.timestamp == 100 && ev.id == 1 && ev.value == 10);
+
+#ifdef UNITTEST_MUST_FAIL
+#warning "UNITTEST_MUST_FAIL: pop() is not accessible (ring_buffer is a private base)"
+  mq.pop(ev);
+#endif
+
+  /* bounded batch drain */
+  sum = 0;
+  assert(mq.drain([&](event_record const & e) { sum += e.value; }, 2) == 2);
+  assert(sum == 50);
+  assert(mq.read_available() == 1);
+
+  /* wrap around */
+  assert(mq.emplace(600u, uint16_t(6), uint16_t(60)));
+  assert(mq.emplace(700u, uint16_t(7), uint16_t(70)));
+  assert(mq.emplace(800u, uint16_t(8), uint16_t(80)));
+  assert(mq.write_available() == 0);
+
+  sum = 0;
+  uint32_t last_ts = 0;
+  assert(mq.drain([&](event_record const & e) {
+        assert(e.timestamp > last_ts);
+        last_ts = e.timestamp;
+        sum += e.value;
+      }) == 4);
+  assert(sum == 40 + 60 + 70 + 80);
+  assert(mq.drain([&](event_record const &) { assert(false); }) == 0);
+  assert(mq.read_available() == 0);
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <arch/nvic.hpp>
+#include <register.hpp>
+#include <iostream>
+#include <cassert>
+
+std::ostream & mptl::sim::regdump_ostream = std::cout;
+
+using namespace mptl;
+
+using prio_usart   = irq_priority< irq::usart<2>, 1, 0 >;  /* irqn=38: IPR9[23:20] */
+using prio_systick = irq_priority< irq::systick,  2 >;     /* SHPR3[31:28] */
+using prio_svcall  = irq_priority< irq::sv_call,  3 >;     /* SHPR2[31:28] */
+
+using prio_group   = irq_priority_grouping< 2 >;
+using prio_adc     = prio_group::irq_priority< irq::adc, 1, 3 >;  /* irqn=18: IPR4[23:20] */
+
+static_assert(prio_usart::priority_value   == 0x10, "priority_value");
+static_assert(prio_systick::priority_value == 0x20, "priority_value");
+static_assert(prio_adc::priority_value     == 0x70, "priority_value");
+static_assert(prio_adc::preempt_bits == 2 && prio_adc::priority == 1 && prio_adc::subpriority == 3, "prio_adc");
+
+static_assert(std::is_same< prio_usart::reg_type, NVIC::IPR<9>::type >::value, "reg_type");
+static_assert(prio_usart::set_mask   == 0x00100000, "set_mask");
+static_assert(prio_usart::clear_mask == 0x00f00000, "clear_mask");
+static_assert(std::is_same< prio_systick::reg_type, SCB::SHPR<2>::type >::value, "reg_type");
+static_assert(prio_systick::set_mask == 0x20000000, "set_mask");
+static_assert(std::is_same< prio_svcall::reg_type, SCB::SHPR<1>::type >::value, "reg_type");
+static_assert(prio_group::set_mask  == 0x05fa0500, "set_mask");
+
+/* irq_priority_grouping<irq::priority_bits> is the reset value (no subpriority) */
+static_assert(irq_priority_grouping< 4 >::set_mask == 0x05fa0300, "set_mask");
+
+using prio_usart3 = irq_priority< irq::usart<3>, 4 >;  /* irqn=39: IPR9[31:28] */
+
+using resources = typelist<
+  prio_usart,
+  prio_usart,     /* identical declaration is fine */
+  prio_usart3,
+  prio_systick,
+  prio_svcall,
+  prio_group,
+  prio_adc
+  >;
+
+static_assert(make_reglist< resources >::merged_regmask< NVIC::IPR<9> >::set_mask   == 0x40100000, "merged IPR9");
+static_assert(make_reglist< resources >::merged_regmask< NVIC::IPR<9> >::clear_mask == 0xf0f00000, "merged IPR9");
+
+int main()
+{
+  std::cout << "*** unittest nvic_priority ***" << std::endl;
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "set/clear check failed: setting a bit which was previously cleared"
+  make_reglist< resources, irq_priority< irq::usart<2>, 2 > >::reset_to();
+#endif
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "preemption priority out of range"
+  make_reglist< prio_group::irq_priority< irq::adc, 4 > >::reset_to();
+#endif
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "priority of reset, nmi and hard_fault is fixed"
+  make_reglist< irq_priority< irq::hard_fault, 1 > >::reset_to();
+#endif
+
+  make_reglist< resources >::reset_to();
+
+  assert(NVIC::IPR<9>::load() == 0x40100000);
+  assert(NVIC::IPR<4>::load() == 0x00700000);
+  assert(SCB::SHPR<2>::load() == 0x20000000);
+  assert(SCB::SHPR<1>::load() == 0x30000000);
+  assert(SCB::AIRCR::PRIGROUP::load_and_shift() == 5);
+
+  /* runtime change */
+  irq_priority< irq::usart<2>, 3 >::set();
+  assert(NVIC::IPR<9>::load() == 0x40300000);
+
+  return 0;
+}
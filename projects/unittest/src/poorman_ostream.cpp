@@ -0,0 +1,140 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <poorman_ostream.hpp>
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+using namespace poorman;
+
+/** poorman::ostream<> writing to std::string, counting calls */
+struct string_ostream : public ostream<char>
+{
+  std::string str;
+  unsigned calls = 0;
+
+  ostream<char> & put(char c) { calls++; str += c; return *this; }
+  ostream<char> & puts(const char * s) { calls++; str += s; return *this; }
+  ostream<char> & write(const char * s, unsigned int count) { calls++; str.append(s, count); return *this; }
+  ostream<char> & flush() { return *this; }
+  ostream<char> & endl() { str += '\n'; return *this; }
+
+  std::string take() { std::string s = str; str.clear(); calls = 0; return s; }
+};
+
+/** poorman::static_ostream<> writing to std::string */
+struct static_string_ostream : public static_ostream<static_string_ostream, char>
+{
+  std::string str;
+  unsigned flushes = 0;
+
+  static_string_ostream & put(char c) { str += c; return *this; }
+  static_string_ostream & puts(const char * s) { str += s; return *this; }
+  static_string_ostream & write(const char * s, unsigned int count) { str.append(s, count); return *this; }
+  static_string_ostream & flush() { flushes++; return *this; }
+  static_string_ostream & endl() { str += '\n'; return flush(); }
+};
+
+static void print_virtual(ostream<char> & os) {
+  os << "v:" << dec << 42 << endl;
+}
+
+static void test_static_ostream()
+{
+  static_string_ostream os;
+
+  os << "x=" << uint16_t(0xbeef) << " " << dec << -7 << " " << setfill('0') << setw(3) << 5u << endl;
+  assert(os.str == "x=beef -7 005\n");
+  assert(os.flushes == 1);
+  os << hex << flush;
+  assert(os.flushes == 2);
+
+  /* type-erased adapter, with separate formatting state */
+  ostream_adapter<static_string_ostream> adapter(os);
+  os.str.clear();
+  print_virtual(adapter);
+  os << 42;
+  assert(os.str == "v:42\n0000002a");
+  assert(os.flushes == 3);
+}
+
+static std::string utoa(uint64_t value) {
+  char buf[24];
+  char * end = buf + sizeof(buf);
+  return std::string(utoa_rev(end, value), end);
+}
+
+int main()
+{
+  std::cout << "*** unittest poorman_ostream ***" << std::endl;
+
+  string_ostream os;
+
+  /* digit-pair itoa */
+  assert(utoa(0) == "0");
+  assert(utoa(7) == "7");
+  assert(utoa(10) == "10");
+  assert(utoa(99) == "99");
+  assert(utoa(100) == "100");
+  assert(utoa(1234567) == "1234567");
+  assert(utoa(4294967295u) == "4294967295");
+  assert(utoa(18446744073709551615ull) == "18446744073709551615");
+  for(unsigned i = 0; i < 100000; i += 7)
+    assert(utoa(i) == std::to_string(i));
+
+  /* default: fixed-width hex (backward compatible) */
+  os << uint32_t(0x2a);
+  assert(os.calls == 1);
+  assert(os.take() == "0000002a");
+  os << uint8_t(0xf) << int16_t(-1);
+  assert(os.take() == "0fffff");
+
+  /* decimal, single write() per number */
+  os << dec << 0u << " " << 1234567u;
+  assert(os.calls == 3);
+  assert(os.take() == "0 1234567");
+  os << -42 << " " << int8_t(-128) << " " << int64_t(-9223372036854775807ll - 1);
+  assert(os.take() == "-42 -128 -9223372036854775808");
+  os << uint64_t(18446744073709551615ull);
+  assert(os.take() == "18446744073709551615");
+
+  /* width is reset after each number */
+  os << setw(5) << 42 << "|" << 42;
+  assert(os.take() == "   42|42");
+  os << setw(5) << -42;
+  assert(os.take() == "  -42");
+  os << setfill('0') << setw(5) << -42 << " " << setw(3) << 7;
+  assert(os.take() == "-0042 007");
+  os << setw(2) << 12345;
+  assert(os.take() == "12345");
+  os << setfill(' ') << setw(100) << 1;
+  assert(os.take() == std::string(31, ' ') + "1");
+
+  /* hex with width */
+  os << hex << setw(4) << 0xabu << " " << setfill('0') << setw(4) << 0xabu;
+  assert(os.take() == "  ab 00ab");
+  os << setw(1) << uint32_t(0) << " " << uint16_t(0);
+  assert(os.take() == "0 0000");
+
+  test_static_ostream();
+
+  return 0;
+}
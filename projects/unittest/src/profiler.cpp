@@ -0,0 +1,129 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <profiler.hpp>
+#include <iostream>
+#include <string>
+#include <cassert>
+
+using namespace mptl;
+
+/* fake clock, advanced manually */
+static uint32_t fake_time;
+struct fake_clock {
+  static uint32_t now(void) { return fake_time; }
+};
+
+struct prof_outer : profile_point< prof_outer > { static constexpr const char * name = "outer"; };
+struct prof_inner : profile_point< prof_inner > { static constexpr const char * name = "inner"; };
+
+using test_profiler = profiler< prof_outer, prof_inner >;
+
+class string_ostream : public poorman::ostream<char>
+{
+public:
+  std::string str;
+  string_ostream & put(char c) { str += c; return *this; }
+  string_ostream & puts(const char* s) { str += s; return *this; }
+  string_ostream & write(const char* s, unsigned int count) { str.append(s, count); return *this; }
+  string_ostream & flush() { return *this; }
+  string_ostream & endl() { str += '\n'; return *this; }
+};
+
+int main()
+{
+  std::cout << "*** unittest profiler ***" << std::endl;
+
+  /* log2 buckets */
+  assert(profile_stats::bucket(0) == 0);
+  assert(profile_stats::bucket(1) == 0);
+  assert(profile_stats::bucket(2) == 1);
+  assert(profile_stats::bucket(3) == 1);
+  assert(profile_stats::bucket(1024) == 10);
+  assert(profile_stats::bucket(2047) == 10);
+  assert(profile_stats::bucket(~0u) == 31);
+
+  test_profiler::reset();
+
+  /* single scope */
+  fake_time = 1000;
+  {
+    profile_scope< prof_outer, fake_clock > scope;
+    fake_time += 100;
+  }
+  assert(prof_outer::stats.count == 1);
+  assert(prof_outer::stats.min == 100 && prof_outer::stats.max == 100);
+  assert(prof_outer::stats.mean() == 100 && prof_outer::stats.self_mean() == 100);
+
+  /* nested scopes: inner time is not accounted as self time of outer */
+  {
+    profile_scope< prof_outer, fake_clock > scope;
+    fake_time += 50;
+    for(int i = 0; i < 2; i++) {
+      profile_scope< prof_inner, fake_clock > inner;
+      fake_time += 100;
+    }
+    fake_time += 50;
+  }
+  assert(prof_outer::stats.count == 2);
+  assert(prof_outer::stats.min == 100 && prof_outer::stats.max == 300);
+  assert(prof_outer::stats.last == 300);
+  assert(prof_outer::stats.total == 400 && prof_outer::stats.self_total == 200);
+  assert(prof_inner::stats.count == 2 && prof_inner::stats.total == 200);
+  assert(prof_inner::stats.self_total == 200);
+
+  /* counter wrap-around */
+  fake_time = ~0u - 9;
+  {
+    profile_scope< prof_inner, fake_clock > scope;
+    fake_time += 30;
+  }
+  assert(prof_inner::stats.last == 30 && prof_inner::stats.min == 30);
+
+  assert(prof_outer::stats.hist[6] == 1);  /* 100: [64, 128) */
+  assert(prof_outer::stats.hist[8] == 1);  /* 300: [256, 512) */
+  assert(prof_inner::stats.hist[4] == 1);  /* 30: [16, 32) */
+  assert(prof_inner::stats.hist[6] == 2);
+
+  string_ostream out;
+  test_profiler::dump(out, "cyc");
+  std::cout << out.str;
+  assert(out.str ==
+         "outer: n=2 min=100 mean=200 max=300 self=100 [cyc]\n"
+         "  <2^7:1 <2^9:1\n"
+         "inner: n=3 min=30 mean=76 max=100 self=76 [cyc]\n"
+         "  <2^5:1 <2^7:2\n");
+
+  test_profiler::reset();
+  assert(prof_outer::stats.count == 0 && prof_inner::stats.count == 0);
+  out.str.clear();
+  test_profiler::dump(out, "cyc");
+  assert(out.str ==
+         "outer: n=0 min=0 mean=0 max=0 self=0 [cyc]\n"
+         "inner: n=0 min=0 mean=0 max=0 self=0 [cyc]\n");
+
+  /* host clock (simulation) */
+  {
+    profile_scope< prof_outer > scope;
+  }
+  assert(prof_outer::stats.count == 1);
+
+  return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <scheduler.hpp>
+#include <iostream>
+#include <cassert>
+#include <cstring>
+
+static unsigned tick;
+static unsigned get_tick(void) { return tick; }
+
+/* run log: one character per task run */
+static char trace[64];
+static unsigned trace_len;
+
+static void log_run(char c) {
+  assert(trace_len < sizeof(trace) - 1);
+  trace[trace_len++] = c;
+  trace[trace_len] = 0;
+}
+
+static bool input_pending;
+
+struct input_task : mptl::scheduler_task<>
+{
+  static bool pending(void) { return input_pending; }
+  static void run(void) { input_pending = false; log_run('i'); }
+};
+
+static unsigned event_renotify;
+
+struct event_task : mptl::scheduler_task<>
+{
+  static void run(void);
+};
+
+struct fast_task : mptl::scheduler_task< 2 >
+{
+  static void run(void) { log_run('f'); }
+};
+
+struct slow_task : mptl::scheduler_task< 10 >
+{
+  static void run(void) { log_run('s'); }
+};
+
+struct unregistered_task : mptl::scheduler_task<> { };
+
+/* tasks contributed by a module as a (nested) typelist */
+struct module_task_a : mptl::scheduler_task< 3 >
+{
+  static void run(void) { log_run('a'); }
+};
+
+struct module_task_b : mptl::scheduler_task<>
+{
+  static void run(void) { log_run('b'); }
+};
+
+using module_tasks = mptl::typelist< module_task_a, void, mptl::typelist< module_task_b > >;
+using composed_scheduler = mptl::scheduler< get_tick, fast_task, module_tasks, void >;
+
+using scheduler = mptl::scheduler< get_tick, input_task, event_task, fast_task, slow_task >;
+
+void event_task::run(void) {
+  log_run('e');
+  if(event_renotify) {
+    event_renotify--;
+    scheduler::notify< event_task >();
+  }
+}
+
+/* run all ready tasks, return the run log */
+static const char * run_ready(void) {
+  trace_len = 0;
+  trace[0] = 0;
+  while(scheduler::run_once());
+  return trace;
+}
+
+int main()
+{
+  std::cout << "*** unittest scheduler ***" << std::endl;
+
+  static_assert(scheduler::task_count == 4, "task_count");
+
+  /* all periodic tasks are due after reset, in priority order */
+  tick = 100;
+  scheduler::reset();
+  assert(scheduler::ready());
+  assert(std::strcmp(run_ready(), "fs") == 0);
+  assert(!scheduler::ready());
+  assert(scheduler::run_once() == false);
+
+  /* periods */
+  tick = 101;
+  assert(std::strcmp(run_ready(), "") == 0);
+  tick = 102;
+  assert(std::strcmp(run_ready(), "f") == 0);
+  tick = 110;
+  assert(std::strcmp(run_ready(), "fs") == 0);  /* missed periods are skipped */
+  tick = 111;
+  assert(std::strcmp(run_ready(), "") == 0);
+  tick = 112;
+  assert(std::strcmp(run_ready(), "f") == 0);
+
+  /* event wakeup */
+  scheduler::notify< event_task >();
+  assert(scheduler::ready());
+  assert(std::strcmp(run_ready(), "e") == 0);
+  assert(!scheduler::ready());
+
+  /* wakeup of a periodic task before its period elapsed */
+  scheduler::notify< slow_task >();
+  assert(std::strcmp(run_ready(), "s") == 0);
+
+  /* notify is not lost if posted while the task is running */
+  event_renotify = 2;
+  scheduler::notify< event_task >();
+  assert(std::strcmp(run_ready(), "eee") == 0);
+
+  /* level-triggered wakeup, priority order */
+  input_pending = true;
+  scheduler::notify< event_task >();
+  tick = 114;
+  trace_len = 0;
+  assert(scheduler::run_once());
+  assert(std::strcmp(trace, "i") == 0);
+  assert(std::strcmp(run_ready(), "ef") == 0);
+
+  /* ticks until next periodic task is due (for tickless idle) */
+  assert(scheduler::ticks_until_due() == 2);   /* fast_task: 116 */
+  assert(scheduler::ticks_until_due(1) == 1);
+  tick = 115;
+  assert(scheduler::ticks_until_due() == 1);
+  tick = 116;
+  assert(scheduler::ticks_until_due() == 0);
+  assert(std::strcmp(run_ready(), "f") == 0);
+  tick = 119;
+  assert(scheduler::ticks_until_due() == 0);   /* fast_task overdue */
+  assert(std::strcmp(run_ready(), "f") == 0);
+  assert(scheduler::ticks_until_due() == 1);   /* slow_task: 120 */
+
+  /* tick wrap-around */
+  tick = ~0u - 2;
+  scheduler::reset();
+  assert(std::strcmp(run_ready(), "fs") == 0);
+  tick = ~0u;
+  assert(std::strcmp(run_ready(), "f") == 0);
+  tick = 0;
+  assert(std::strcmp(run_ready(), "") == 0);
+  tick = 1;
+  assert(std::strcmp(run_ready(), "f") == 0);
+  assert(scheduler::ticks_until_due() == 2);
+  tick = 7;
+  assert(std::strcmp(run_ready(), "fs") == 0);
+
+  /* reset clears pending events */
+  scheduler::notify< event_task >();
+  scheduler::reset();
+  assert(std::strcmp(run_ready(), "fs") == 0);
+
+  /* tasks from a nested typelist are flattened, void is removed */
+  static_assert(composed_scheduler::task_count == 3, "task_count");
+  tick = 200;
+  composed_scheduler::reset();
+  trace_len = 0;
+  trace[0] = 0;
+  while(composed_scheduler::run_once());
+  assert(std::strcmp(trace, "fa") == 0);
+  composed_scheduler::notify< module_task_b >();
+  tick = 203;
+  trace_len = 0;
+  trace[0] = 0;
+  while(composed_scheduler::run_once());
+  assert(std::strcmp(trace, "fab") == 0);
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "task is not registered in scheduler<>"
+  scheduler::notify< unregistered_task >();
+#endif
+
+  return 0;
+}
@@ -0,0 +1,436 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <terminal.hpp>
+#include <fifo.hpp>
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <cstring>
+
+using namespace mptl;
+
+/** poorman::ostream<> writing to std::string */
+struct string_ostream : public poorman::ostream<char>
+{
+  std::string str;
+
+  poorman::ostream<char> & put(char c) { str += c; return *this; }
+  poorman::ostream<char> & puts(const char * s) { str += s; return *this; }
+  poorman::ostream<char> & write(const char * s, unsigned int count) { str.append(s, count); return *this; }
+  poorman::ostream<char> & flush() { return *this; }
+  poorman::ostream<char> & endl() { str += '\n'; return *this; }
+};
+
+static unsigned run_count[5];
+
+struct hook_alpha {
+  static constexpr const char * cmd  = "alpha";
+  static constexpr const char * desc = "first hook";
+  void run(poorman::ostream<char> & cout) { run_count[0]++; cout << "A"; }
+};
+
+struct hook_beta {
+  static constexpr const char * cmd  = "beta";
+  static constexpr const char * desc = "second hook";
+  void run(poorman::ostream<char> & cout) { run_count[1]++; cout << "B"; }
+};
+
+struct hook_long {
+  static constexpr const char * cmd  = "verylongcommand";
+  static constexpr const char * desc = "long command";
+  void run(poorman::ostream<char> & cout) { run_count[2]++; cout << "L"; }
+};
+
+struct hook_alpha2 {
+  static constexpr const char * cmd  = "alpha2";
+  static constexpr const char * desc = "prefix of alpha";
+  void run(poorman::ostream<char> & cout) { run_count[3]++; cout << "2"; }
+};
+
+static uint32_t poke_addr;
+static int poke_val;
+
+struct hook_poke {
+  static constexpr const char * cmd  = "poke";
+  static constexpr const char * desc = "takes arguments";
+  void run(poorman::ostream<char> & cout, terminal_args const & args) {
+    run_count[4]++;
+    if(!args.get_hex(1, poke_addr) || !args.get_int(2, poke_val))
+      cout << "usage";
+  }
+  void run_binary(terminal_binary_frame & frame) {
+    run_count[4]++;
+    if(frame.get(0, poke_addr) && frame.get(4, poke_val))
+      frame.put(poke_addr + poke_val);
+  }
+};
+
+/** resumable: prints 0..n-1, one number per step */
+struct hook_count {
+  static constexpr const char * cmd  = "count";
+  static constexpr const char * desc = "resumable";
+  bool step(poorman::ostream<char> & cout, terminal_job & job) {
+    unsigned n = 0;
+    job.args().get_int(1, n);
+    assert(job.count == job.state);
+    if(job.state >= n)
+      return false;
+    cout << poorman::dec << job.state << poorman::hex << poorman::endl;
+    return ++job.state < n;
+  }
+};
+
+using commands = terminal_hook_list< hook_alpha, hook_beta, hook_long, hook_alpha2, hook_poke, hook_count >;
+using short_commands = terminal_hook_list< hook_alpha, hook_beta >;
+
+static_assert(mpl::fnv1a_hash("") == 2166136261u, "fnv1a_hash of empty string");
+static_assert(mpl::fnv1a_hash("a") == 0xe40c292cu, "fnv1a_hash of \"a\"");
+static_assert(mpl::const_strlen("verylongcommand") == 15, "const_strlen");
+static_assert(commands::cmd_maxlen == 15, "cmd_maxlen of commands");
+static_assert(short_commands::cmd_maxlen == 8, "cmd_maxlen is at least 8");
+static_assert(terminal_hook_list<>::cmd_maxlen == 8, "cmd_maxlen of empty list");
+
+static std::string exec(const char * cmd) {
+  string_ostream os;
+  commands::execute(cmd, os);
+  return os.str;
+}
+
+static std::string exec_line(const char * line) {
+  char buf[80];
+  terminal_args args;
+  string_ostream os;
+  strcpy(buf, line);
+  if(args.tokenize(buf))
+    commands::execute(args, os);
+  return os.str;
+}
+
+/** stream device, feeding terminal<> from/to plain fifos */
+struct test_device {
+  using fifo_type = ring_buffer<char, 256>;
+  using resources = void;
+  static constexpr bool crlf = true;
+  static fifo_type rx_fifo;
+  static fifo_type tx_fifo;
+  static void open() { }
+  static void close() { }
+  static void flush() { }
+};
+test_device::fifo_type test_device::rx_fifo;
+test_device::fifo_type test_device::tx_fifo;
+
+static std::string slip_frame(std::string const & data) {
+  uint16_t crc = slip::crc16(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  std::string raw = data + char(crc >> 8) + char(crc & 0xff);
+  std::string frame(1, char(slip::END));
+  for(char c : raw) {
+    if(uint8_t(c) == slip::END)      frame += { char(slip::ESC), char(slip::ESC_END) };
+    else if(uint8_t(c) == slip::ESC) frame += { char(slip::ESC), char(slip::ESC_ESC) };
+    else                             frame += c;
+  }
+  return frame + char(slip::END);
+}
+
+template<typename terminal_type>
+static std::string feed(terminal_type & term, std::string const & input) {
+  std::string output;
+  char c;
+  test_device::rx_fifo.pushs(input.data(), input.size());
+  term.template process_input<commands>();
+  while(test_device::tx_fifo.pop(c))
+    output += c;
+  return output;
+}
+
+static void test_binary()
+{
+  terminal<test_device> term;
+  std::string req;
+  std::string out;
+
+  static_assert(slip::ESC != 0 && slip::END != 0, "");
+  assert(slip::crc16(reinterpret_cast<const uint8_t *>("123456789"), 9) == 0x29b1);  /* check value */
+
+  assert(feed(term, "beta\r") == "beta\r\nB# ");
+
+  /* hook_poke (id=4): address contains END and ESC characters (escaped) */
+  uint32_t addr = 0x11c0db22;
+  int32_t val = 2;
+  uint32_t sum = addr + val;
+  req = std::string(1, 4) + std::string(reinterpret_cast<char *>(&addr), 4) + std::string(reinterpret_cast<char *>(&val), 4);
+  out = feed(term, slip_frame(req));
+  assert(term.is_binary_mode());
+  assert(out == slip_frame(std::string(1, 4) + std::string(1, 0) + std::string(reinterpret_cast<char *>(&sum), 4)));
+  assert(poke_addr == addr && poke_val == 2);
+
+  /* no echo in binary mode; hook without run_binary(); unknown id */
+  out = feed(term, slip_frame(std::string(1, 0)) + slip_frame(std::string(1, 42)));
+  assert(out == slip_frame(std::string{ 0, 2 }) + slip_frame(std::string{ 42, 1 }));
+  assert(run_count[0] == 2);
+
+  /* bad crc, bad escape, empty frames: dropped */
+  std::string bad = slip_frame(std::string(1, 0));
+  bad[2] ^= 1;
+  std::string bad_esc = std::string{ char(slip::END), 0, char(slip::ESC), 0x55, char(slip::END) };
+  assert(feed(term, bad + bad_esc + std::string(3, char(slip::END))) == "");
+  assert(term.frame_errors() == 2);
+
+  /* oversized frame is dropped */
+  assert(feed(term, slip_frame(std::string(200, 1))) == "");
+  assert(term.frame_errors() == 3);
+
+  /* back to text mode */
+  out = feed(term, slip_frame(std::string(1, char(0xff))));
+  assert(out == slip_frame(std::string{ char(0xff), 0 }) + "# ");
+  assert(!term.is_binary_mode());
+  assert(feed(term, "alpha\r") == "alpha\r\nA# ");
+}
+
+static void test_line_editing()
+{
+  terminal<test_device> term;
+  const std::string up   = "\x1b[A";
+  const std::string down = "\x1b[B";
+
+  /* backspace (BS and DEL) */
+  assert(feed(term, "alphx\x7f" "a\r") == "alphx\b \ba\r\nA# ");
+  assert(feed(term, "\x08\x08" "betx\x08" "a\r") == "betx\b \ba\r\nB# ");
+
+  /* history: up/down, minimal rewrite of differing part */
+  assert(feed(term, up) == "beta");
+  assert(feed(term, up) == "\b\b\b\balpha");  /* "beta" -> "alpha" */
+  assert(feed(term, up) == "");                /* no more history */
+  assert(feed(term, down) == "\x1b[5Dbeta\x1b[K");  /* ESC [ n D for n > 4 */
+  assert(feed(term, down) == "\b\b\b\b\x1b[K");
+  assert(feed(term, down) == "");
+
+  /* recall, edit, execute */
+  assert(feed(term, "\x1bOA\r") == "beta\r\nB# ");  /* ESC O A (application mode) */
+  assert(feed(term, up) == "beta");             /* consecutive duplicate not stored */
+  assert(feed(term, up) == "\b\b\b\balpha");
+  assert(feed(term, "2\r") == "2\r\n2# ");
+  assert(feed(term, up + up) == "alpha2\x1b[6Dbeta\x1b[K");
+
+  /* common prefix is kept */
+  assert(feed(term, "\x15") == "\b\b\b\b\x1b[K");  /* Ctrl-U */
+  assert(feed(term, "alpha\r") == "alpha\r\nA# ");
+  assert(feed(term, up + up) == "alpha2");       /* "alpha" -> "alpha2": appends "2" only */
+  assert(feed(term, "\x15") == "\x1b[6D\x1b[K");
+
+  /* unknown escape sequences are ignored */
+  assert(feed(term, "\x1b[1;5C" "beta\r") == "beta\r\nB# ");
+
+  /* history ring keeps history_size entries */
+  feed(term, "h1\r" "h2\r" "h3\r" "h4\r");
+  assert(feed(term, up + up + up + up) == "h4\b3\b2\b1");
+  assert(feed(term, up) == "");
+  feed(term, "\x15");
+
+  /* line full: bell */
+  std::string line(terminal<test_device>::cmd_buf_size - 1, 'x');
+  assert(feed(term, line) == line);
+  assert(feed(term, "y") == "\a");
+  feed(term, "\x15");
+
+  /* history disabled */
+  terminal<test_device, true, 0> term_nohist;
+  assert(feed(term_nohist, "beta\r") == "beta\r\nB# ");
+  assert(feed(term_nohist, up) == "");
+}
+
+static void test_resumable()
+{
+  terminal<test_device> term;
+
+  static_assert(mpl::terminal_hook_is_resumable<hook_count>::value, "hook_count is resumable");
+  static_assert(!mpl::terminal_hook_is_resumable<hook_alpha>::value, "hook_alpha is not resumable");
+
+  /* without terminal: run to completion */
+  assert(exec_line("count 3") == "0\n1\n2\n");
+  assert(exec_line("count 0") == "");
+
+  /* one step per process_input() */
+  assert(feed(term, "count 3\r") == "count 3\r\n0\r\n");
+  assert(term.is_busy());
+  assert(feed(term, "") == "1\r\n");
+  assert(feed(term, "") == "2\r\n# ");
+  assert(!term.is_busy());
+
+  /* input is discarded while busy */
+  unsigned beta_runs = run_count[1];
+  assert(feed(term, "count 2\rbeta\r") == "count 2\r\n0\r\n");
+  assert(feed(term, "beta\r") == "1\r\n# ");
+  assert(run_count[1] == beta_runs);
+
+  /* Ctrl-C aborts */
+  assert(feed(term, "count 100\r") == "count 100\r\n0\r\n");
+  assert(feed(term, "") == "1\r\n");
+  assert(feed(term, "x\x03") == "^C\r\n# ");
+  assert(!term.is_busy());
+  assert(feed(term, "beta\r") == "beta\r\nB# ");
+
+  /* single step job: no busy state */
+  assert(feed(term, "count 1\r") == "count 1\r\n0\r\n# ");
+  assert(!term.is_busy());
+
+  /* arguments stay valid while running */
+  assert(feed(term, "count 2\r") == "count 2\r\n0\r\n");
+  assert(feed(term, "") == "1\r\n# ");
+
+  /* no step while tx_fifo is too full (yield to other tasks) */
+  assert(feed(term, "count 3\r") == "count 3\r\n0\r\n");
+  assert(term.pending());
+  std::string fill(test_device::tx_fifo.write_available() - term.job_tx_space + 1, 'x');
+  test_device::tx_fifo.pushs(fill.data(), fill.size());
+  assert(term.is_busy() && !term.job_ready() && !term.pending());
+  term.process_input<commands>();
+  assert(test_device::tx_fifo.read_available() == fill.size());
+  assert(feed(term, "") == fill);  /* drained (e.g. by tx interrupt) */
+  assert(term.pending());
+  assert(feed(term, "") == "1\r\n");
+  assert(feed(term, "") == "2\r\n# ");
+  assert(!term.pending());
+}
+
+static void test_atoi()
+{
+  int i = 42;
+  unsigned u = 42;
+  uint8_t u8 = 42;
+  int8_t i8 = 42;
+  uint32_t u32 = 42;
+
+  assert(poorman::atoi("0", i) && i == 0);
+  assert(poorman::atoi("1234", i) && i == 1234);
+  assert(poorman::atoi("-1234", i) && i == -1234);
+  assert(poorman::atoi("0x1f", i) && i == 0x1f);
+  assert(poorman::atoi("-0x10", i) && i == -16);
+  assert(poorman::atoi("4294967295", u) && u == 4294967295u);
+  assert(!poorman::atoi("4294967296", u) && u == 4294967295u);
+  assert(!poorman::atoi("-1", u));
+  assert(!poorman::atoi("", i));
+  assert(!poorman::atoi("-", i));
+  assert(!poorman::atoi("12a", i));
+  assert(poorman::atoi("255", u8) && u8 == 255);
+  assert(!poorman::atoi("256", u8) && u8 == 255);
+  assert(poorman::atoi("127", i8) && i8 == 127);
+  assert(!poorman::atoi("128", i8));
+  assert(poorman::atoi("-128", i8) && i8 == -128);
+  assert(!poorman::atoi("-129", i8));
+
+  assert(poorman::atoi_hex("deadBEEF", u32) && u32 == 0xdeadbeef);
+  assert(poorman::atoi_hex("0x40021000", u32) && u32 == 0x40021000);
+  assert(!poorman::atoi_hex("0x", u32));
+  assert(!poorman::atoi_hex("123456789", u32));
+  assert(!poorman::atoi_hex("0xg", u32) && u32 == 0x40021000);
+  assert(poorman::atoi_hex("ff", u8) && u8 == 0xff);
+  assert(!poorman::atoi_hex("100", u8));
+}
+
+static void test_tokenize()
+{
+  terminal_args args;
+  char buf[80];
+
+  strcpy(buf, "");
+  assert(args.tokenize(buf) == 0);
+  strcpy(buf, "   ");
+  assert(args.tokenize(buf) == 0);
+
+  strcpy(buf, "  poke  0x20000000 42 ");
+  assert(args.tokenize(buf) == 3);
+  assert(strcmp(args[0], "poke") == 0);
+  assert(strcmp(args[1], "0x20000000") == 0);
+  assert(strcmp(args[2], "42") == 0);
+  assert(strcmp(args[3], "") == 0);
+  assert(args[0] == &buf[2]);  /* in-place */
+
+  uint32_t addr;
+  unsigned val;
+  assert(args.get_hex(1, addr) && addr == 0x20000000);
+  assert(args.get_int(2, val) && val == 42);
+  assert(!args.get_int(3, val));
+
+  strcpy(buf, "a b c d e f g h i j");
+  assert(args.tokenize(buf) == terminal_args::max_argc);
+  assert(strcmp(args[terminal_args::max_argc - 1], "h") == 0);
+}
+
+int main()
+{
+  std::cout << "*** unittest terminal ***" << std::endl;
+
+  assert(mpl::fnv1a_hash_runtime("alpha") == mpl::fnv1a_hash("alpha"));
+  assert(mpl::fnv1a_hash_runtime("verylongcommand") == mpl::fnv1a_hash("verylongcommand"));
+
+  /* table is sorted by hash */
+  using table = commands::table_type;
+  for(std::size_t i = 1; i < table::size; i++)
+    assert(table::value[i - 1].hash < table::value[i].hash);
+
+  assert(exec("alpha") == "A");
+  assert(exec("beta") == "B");
+  assert(exec("verylongcommand") == "L");
+  assert(exec("alpha2") == "2");
+  assert(run_count[0] == 1 && run_count[1] == 1 && run_count[2] == 1 && run_count[3] == 1);
+
+  /* no partial matches */
+  assert(exec("alph") == std::string("alph") + i18n::terminal::cmd_notfound + "\n");
+  assert(exec("alpha22") == std::string("alpha22") + i18n::terminal::cmd_notfound + "\n");
+  assert(exec("") == std::string(i18n::terminal::cmd_notfound) + "\n");
+  assert(run_count[0] == 1 && run_count[3] == 1);
+
+  /* help lists commands in order of declaration */
+  std::string help = exec("help");
+  std::cout << help;
+  assert(help.find(i18n::terminal::cmd_list) == 0);
+  assert(help.find("   alpha             first hook\n") != std::string::npos);
+  assert(help.find("   verylongcommand   long command\n") != std::string::npos);
+  assert(help.find("alpha ") < help.find("beta "));
+  assert(help.find("beta ") < help.find("verylongcommand "));
+  assert(help.find("verylongcommand ") < help.find("alpha2 "));
+
+  /* hooks with arguments */
+  assert(exec_line("poke 1000 -5") == "");
+  assert(run_count[4] == 1 && poke_addr == 0x1000 && poke_val == -5);
+  assert(exec_line("poke 1000") == "usage");
+  assert(exec_line("  alpha  ignored args") == "A");
+  assert(run_count[0] == 2);
+  assert(exec_line("nope arg") == std::string("nope") + i18n::terminal::cmd_notfound + "\n");
+
+  test_atoi();
+  test_tokenize();
+  test_binary();
+  test_line_editing();
+  test_resumable();
+
+  /* empty hook list */
+  string_ostream os;
+  terminal_hook_list<>::execute("alpha", os);
+  assert(os.str == std::string("alpha") + i18n::terminal::cmd_notfound + "\n");
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "terminal hook command hash collision (or duplicate command)"
+  terminal_hook_list< hook_alpha, hook_beta, hook_alpha >::execute("alpha", os);
+#endif
+
+  return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <timer_wheel.hpp>
+#include <iostream>
+#include <cassert>
+
+using namespace mptl;
+
+/* small wheel: 4 slots per level, 3 levels (range: 64 ticks) */
+using wheel_type = timer_wheel< 2, 3 >;
+static wheel_type wheel;
+
+static unsigned tick;
+static unsigned fired[4];
+static unsigned fired_tick[4];
+
+template< unsigned n >
+static void on_expiry(void) {
+  fired[n]++;
+  fired_tick[n] = wheel.now();
+}
+
+static wheel_type::timer timer[4];
+
+/* simulates isr calls to advance() while the wheel is locked (deferred) */
+static void on_isr_advance(void) {
+  fired[2]++;
+  wheel.advance(wheel.now() + 5);
+  wheel.advance(wheel.now() + 2);
+}
+
+static void clear(void) {
+  for(unsigned i = 0; i < 4; i++)
+    fired[i] = fired_tick[i] = 0;
+}
+
+/* advance tick by tick, as done by systick isr */
+static void run_ticks(unsigned n) {
+  while(n--)
+    wheel.advance(++tick);
+}
+
+/* start timer n, check expiry on exact tick (single ticks and bulk advance) */
+static void check_expiry(unsigned start_tick, unsigned ticks) {
+  for(unsigned bulk = 0; bulk < 2; bulk++) {
+    tick = start_tick;
+    wheel.reset(tick);
+    clear();
+    wheel.start(timer[0], ticks, on_expiry<0>);
+    assert(timer[0].armed());
+    if(bulk) {
+      wheel.advance(tick + ticks - 1);
+      assert(fired[0] == 0);
+      wheel.advance(tick + ticks);
+      tick += ticks;
+    }
+    else {
+      run_ticks(ticks - 1);
+      assert(fired[0] == 0);
+      run_ticks(1);
+    }
+    assert(fired[0] == 1);
+    assert(fired_tick[0] == start_tick + ticks);
+    assert(!timer[0].armed());
+    run_ticks(200);
+    assert(fired[0] == 1);
+  }
+}
+
+int main()
+{
+  std::cout << "*** unittest timer_wheel ***" << std::endl;
+
+  static_assert(wheel_type::slots == 4, "slots");
+  static_assert(wheel_type::range == 64, "range");
+
+  /* all levels, out of range, unaligned start and wrap-around */
+  static const unsigned start_ticks[] = { 0, 1, 3, 5, 17, 1000, ~0u - 70, ~0u - 1 };
+  for(unsigned s : start_ticks) {
+    for(unsigned ticks = 1; ticks < 300; ticks++)
+      check_expiry(s, ticks);
+  }
+
+  /* cancel */
+  tick = 100;
+  wheel.reset(tick);
+  clear();
+  wheel.start(timer[0], 10, on_expiry<0>);
+  wheel.start(timer[1], 10, on_expiry<1>);
+  wheel.start(timer[2], 10, on_expiry<2>);
+  assert(wheel.cancel(timer[1]));
+  assert(!wheel.cancel(timer[1]));
+  assert(!timer[1].armed());
+  run_ticks(10);
+  assert(fired[0] == 1 && fired[1] == 0 && fired[2] == 1);
+
+  /* re-arm while armed */
+  clear();
+  wheel.start(timer[0], 5, on_expiry<0>);
+  wheel.start(timer[0], 20, on_expiry<0>);
+  run_ticks(19);
+  assert(fired[0] == 0);
+  run_ticks(1);
+  assert(fired[0] == 1 && fired_tick[0] == tick);
+
+  /* periodic timer */
+  clear();
+  unsigned start = tick;
+  wheel.start(timer[3], 3, on_expiry<3>, 7);
+  run_ticks(3);
+  assert(fired[3] == 1 && fired_tick[3] == start + 3);
+  run_ticks(7);
+  assert(fired[3] == 2 && fired_tick[3] == start + 10);
+  wheel.advance(tick + 70);  /* bulk advance (e.g. after tickless sleep) */
+  tick += 70;
+  assert(fired[3] == 12 && fired_tick[3] == start + 80);
+  assert(timer[3].armed());
+  assert(wheel.cancel(timer[3]));
+  run_ticks(100);
+  assert(fired[3] == 12);
+
+  /* ticks until next expiry or cascade */
+  tick = 0;
+  wheel.reset(tick);
+  assert(wheel.ticks_until_next() == ~0u);
+  assert(wheel.ticks_until_next(5) == 5);
+  wheel.start(timer[0], 3, on_expiry<0>);
+  assert(wheel.ticks_until_next() == 3);
+  wheel.start(timer[1], 2, on_expiry<1>);
+  assert(wheel.ticks_until_next() == 2);
+  assert(wheel.cancel(timer[1]));
+  assert(wheel.cancel(timer[0]));
+  wheel.start(timer[0], 30, on_expiry<0>);  /* level 2, cascaded on tick 16 */
+  assert(wheel.ticks_until_next() == 16);
+  run_ticks(16);
+  assert(wheel.ticks_until_next() == 12);  /* level 1, cascaded on tick 28 */
+  run_ticks(12);
+  assert(wheel.ticks_until_next() == 2);
+  run_ticks(2);
+  assert(timer[0].armed() == false);
+  assert(wheel.ticks_until_next() == ~0u);
+
+  /*
+   * stale tick: main loop unlock() loads deferred_tick, the isr
+   * advances the wheel before main calls advance(deferred_tick).
+   */
+  tick = 1000;
+  wheel.reset(tick);
+  clear();
+  wheel.start(timer[0], 10, on_expiry<0>);
+  wheel.start(timer[1], 200, on_expiry<1>);
+  run_ticks(5);                   /* isr: advance(1005) */
+  wheel.advance(1003);            /* main: stale advance(1003) */
+  assert(wheel.now() == 1005);
+  assert(fired[0] == 0 && fired[1] == 0);
+  assert(timer[0].armed() && timer[1].armed());
+  assert(wheel.ticks_until_next() == 3);  /* cascade on tick 1008 */
+  run_ticks(5);
+  assert(fired[0] == 1 && fired_tick[0] == 1010);
+  assert(fired[1] == 0);
+
+  /* deferred advance (isr while locked): deferred_tick never moves backwards */
+  clear();
+  wheel.start(timer[2], 3, on_isr_advance);
+  run_ticks(3);                   /* callback (holding lock): advance(tick + 5), then stale advance(tick + 2) */
+  assert(fired[2] == 1);
+  assert(wheel.now() == tick + 5);
+  tick += 5;
+  assert(fired[1] == 0 && timer[1].armed());
+  wheel.cancel(timer[1]);
+
+  return 0;
+}
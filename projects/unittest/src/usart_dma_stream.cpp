@@ -0,0 +1,214 @@
+/*
+ * OpenMPTL - C++ Microprocessor Template Library
+ *
+ * Copyright (C) 2012-2017 Axel Burri <axel@tty0.ch>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <arch/rcc.hpp>
+#include <arch/usart_stream.hpp>
+#include <isr.hpp>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cassert>
+
+std::ostream & mptl::sim::regdump_ostream = std::cout;
+
+using namespace mptl;
+
+using sysclk = system_clock_hse< mhz(168) >;
+using usart_type  = mptl::usart< 2, sysclk, gpio< 'A', 3 >, gpio< 'A', 2 > >;
+using stream_type = usart_dma_stream< usart_type, ring_buffer< char, 16 >, true, true >;
+using dma_type    = stream_type::dma_tx;
+
+/* usart 3: DMA transmission and circular DMA reception */
+using usart_rx_type  = mptl::usart< 3, sysclk, void, void >;
+using stream_rx_type = usart_dma_stream< usart_rx_type, ring_buffer< char, 16 >, true, true, true >;
+using dma_rx_type    = stream_rx_type::dma_rx;
+
+static std::string sent;
+
+/** run the simulated DMA controller, and call the DMA isr on completion */
+static unsigned int run_dma(unsigned int max_count = ~0u) {
+  unsigned int n = dma_type::sim_transfer<char>([](char & c) { sent += c; }, max_count);
+  if(dma_type::sim_irq_pending())
+    mpl::unique_irq_handler< stream_type::resources, dma_type::irq::irqn >::value();
+  return n;
+}
+
+/** run the simulated rx DMA controller (feeding data), and call the DMA isr on HT/TC */
+static void feed_dma(const char * data) {
+  dma_rx_type::sim_transfer<char>([&](char & c) { c = *data++; }, std::strlen(data));
+  if(dma_rx_type::sim_irq_pending())
+    mpl::unique_irq_handler< stream_rx_type::resources, dma_rx_type::irq::irqn >::value();
+}
+
+/** simulate IDLE line detection */
+static void idle_line(void) {
+  usart_rx_type::USARTx::SR::IDLE::set();
+  mpl::unique_irq_handler< stream_rx_type::resources, usart_rx_type::irq::irqn >::value();
+  usart_rx_type::USARTx::SR::IDLE::clear();
+}
+
+static std::string receive_all(void) {
+  std::string s;
+  char c;
+  while(stream_rx_type::rx_fifo.pop(c))
+    s += c;
+  return s;
+}
+
+static void test_rx_irq_priority(void)
+{
+  using resources = typelist<
+    stream_rx_type::resources,
+    irq_priority< usart_rx_type::irq, 2 >,
+    irq_priority< dma_rx_type::irq,   2 >
+    >;
+  static_assert(stream_rx_type::rx_irq_priority_valid< resources >::value, "usart and DMA rx irqs must have the same priority");
+  static_assert(stream_rx_type::rx_irq_priority_valid< stream_rx_type::resources >::value, "no irq_priority<> declared (priority 0)");
+  static_assert(stream_type::rx_irq_priority_valid< typelist< irq_priority< usart_type::irq, 1 > > >::value, "rx_dma not set");
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "usart and DMA rx irqs must have the same priority"
+  static_assert(stream_rx_type::rx_irq_priority_valid< typelist< stream_rx_type::resources, irq_priority< usart_rx_type::irq, 1 > > >::value, "usart and DMA rx irqs must have the same priority");
+#endif
+}
+
+static void test_rx_dma(void)
+{
+  stream_rx_type::open();
+  assert(usart_rx_type::USARTx::CR3::DMAR::test());
+  assert(usart_rx_type::USARTx::CR1::IDLEIE::test());
+  assert(!usart_rx_type::USARTx::CR1::RXNEIE::test());
+  assert(dma_rx_type::is_enabled());
+  assert(dma_rx_type::is_circular());
+  assert(dma_rx_type::get_count() == 16);
+
+  /* data is published on idle line */
+  feed_dma("abc");
+  assert(stream_rx_type::rx_fifo.read_available() == 0);
+  idle_line();
+  assert(receive_all() == "abc");
+
+  /* ... or on half transfer */
+  feed_dma("defghijk");
+  assert(receive_all() == "defghijk");
+
+  /* ... or on transfer complete (wrapping around) */
+  feed_dma("lmnopq");
+  assert(dma_rx_type::get_count() == 15);
+  idle_line();
+  assert(receive_all() == "lmnopq");
+  assert(stream_rx_type::rx_overrun == 0);
+
+  /* overrun: the DMA overwrites the unread "012", the consumer
+   * resyncs to the most recent 15 bytes */
+  feed_dma("0123456");
+  idle_line();
+  feed_dma("789ABCDEFGH");
+  idle_line();
+  assert(stream_rx_type::rx_overrun == 3);
+  assert(receive_all() == "3456789ABCDEFGH");
+  assert(stream_rx_type::rx_fifo.test_and_clear_overrun());
+  assert(!stream_rx_type::rx_fifo.test_and_clear_overrun());
+  idle_line();
+  assert(stream_rx_type::rx_fifo.read_available() == 0);
+  assert(stream_rx_type::rx_overrun == 3);
+
+  /* full lap between two updates (detected by the HT/TC flags) */
+  feed_dma("ijklmnopqrstuvwxyz");
+  assert(stream_rx_type::rx_overrun == 6);
+  assert(receive_all() == "lmnopqrstuvwxyz");
+  assert(stream_rx_type::rx_fifo.test_and_clear_overrun());
+
+  /* rx_fifo capacity is usable without overrun */
+  feed_dma("0123456789ABCDE");
+  idle_line();
+  assert(receive_all() == "0123456789ABCDE");
+  assert(stream_rx_type::rx_overrun == 6);
+  assert(!stream_rx_type::rx_fifo.test_and_clear_overrun());
+
+  /* second overrun before the consumer resyncs: all new bytes are lost */
+  feed_dma("abcdefghijklmnop");
+  assert(stream_rx_type::rx_overrun == 7);
+  feed_dma("qr");
+  idle_line();
+  assert(stream_rx_type::rx_overrun == 9);
+  assert(receive_all() == "defghijklmnopqr");
+  assert(stream_rx_type::rx_fifo.test_and_clear_overrun());
+
+  stream_rx_type::close();
+  assert(!dma_rx_type::is_enabled());
+  assert(!usart_rx_type::USARTx::CR3::DMAR::test());
+}
+
+int main()
+{
+  std::cout << "*** unittest usart_dma_stream ***" << std::endl;
+
+  stream_type::open();
+  assert(usart_type::USARTx::CR3::DMAT::test());
+  assert(dma_type::CR::CHSEL::test_from(4));
+  assert(dma_type::PAR::load() == usart_type::data_register_addr);
+  assert(!dma_type::is_enabled());
+
+  /* single transfer */
+  assert(stream_type::tx_fifo.pushs("hello"));
+  stream_type::flush();
+  assert(dma_type::is_enabled());
+  assert(dma_type::get_count() == 5);
+  assert(run_dma() == 5);
+  assert(sent == "hello");
+  assert(!dma_type::is_enabled());
+  assert(stream_type::tx_fifo.read_available() == 0);
+  assert(stream_type::irq_count == 1);
+
+  /* flush while a transfer is running has no effect */
+  sent.clear();
+  assert(stream_type::tx_fifo.pushs("0123456789"));
+  stream_type::flush();
+  assert(run_dma(4) == 4);
+  assert(stream_type::tx_fifo.write_available() == 5);  /* slots are released on transfer complete */
+  assert(stream_type::tx_fifo.pushs("abcd"));  /* wraps around the end of buffer storage */
+  stream_type::flush();
+  assert(dma_type::get_count() == 6);
+
+  /* transfer complete starts the next block (until end of storage), and so on */
+  assert(run_dma() == 6);
+  assert(dma_type::is_enabled());
+  assert(dma_type::get_count() == 1);
+  assert(run_dma() == 1);
+  assert(dma_type::is_enabled());
+  assert(run_dma() == 3);
+  assert(!dma_type::is_enabled());
+  assert(sent == "0123456789abcd");
+  assert(stream_type::tx_fifo.read_available() == 0);
+  assert(stream_type::irq_count == 4);
+  assert(stream_type::irq_errors == 0);
+
+  /* flush on empty fifo does not start the DMA */
+  stream_type::flush();
+  assert(!dma_type::is_enabled());
+
+  stream_type::close();
+  assert(!usart_type::USARTx::CR3::DMAT::test());
+
+  test_rx_dma();
+  test_rx_irq_priority();
+
+  return 0;
+}
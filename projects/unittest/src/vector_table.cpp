@@ -22,6 +22,8 @@
 #include <iostream>
 #include <cassert>
 
+std::ostream & mptl::sim::regdump_ostream = std::cout;
+
 using namespace mptl;
 
 static unsigned int stack_top = 0;
@@ -29,6 +31,7 @@ static int isr_test = 0;
 
 static void default_isr(void) { isr_test = 0; }
 static void isr_42(void) { isr_test = 42; }
+static void isr_42_fast(void) { isr_test = 4242; }
 
 /* Handler for irq number = 42 */
 using irq42 = irq_handler< irq_base<42>, isr_42 >;
@@ -54,6 +57,36 @@ int main()
   assert((unsigned long)arm_vector_table.isr_vector[vt::irq_channel_offset + 41] == (unsigned long)default_isr);
   assert((unsigned long)arm_vector_table.isr_vector[vt::irq_channel_offset + 42] == (unsigned long)isr_42);
 
+  /* RAM vector table */
+  static_assert(vt::ram_alignment >= sizeof(vt::value), "ram_alignment");
+  static_assert((vt::ram_alignment & (vt::ram_alignment - 1)) == 0, "ram_alignment");
+  static_assert(mpl::vtor_alignment(4 * 98) == 512, "vtor_alignment");
+  static_assert(mpl::vtor_alignment(4 * 16) == 128, "vtor_alignment");
+  assert(((uintptr_t)&vt::ram_value % vt::ram_alignment) == 0);
+  assert((unsigned long)vt::ram_value.stack_top == (unsigned long)&stack_top);
+  for(std::size_t i = 0; i < vt::vt_size; i++)
+    assert(vt::ram_value.isr_vector[i] == arm_vector_table.isr_vector[i]);
+
+  vt::relocate();
+  assert(SCB::VTOR::load() == (uint32_t)(uintptr_t)&vt::ram_value);
+
+  using irq_42 = irq_base<42>;
+  assert(vt::get_handler< irq_42 >() == isr_42);
+  vt::set_handler< irq_42 >(isr_42_fast);
+  assert(vt::get_handler< irq_42 >() == isr_42_fast);
+  vt::ram_value.isr_vector[vt::irq_channel_offset + 42]();
+  assert(isr_test == 4242);
+  vt::restore_handler< irq_42 >();
+  assert(vt::get_handler< irq_42 >() == isr_42);
+
+  /* compile-time (flash) vector table is unchanged */
+  assert((unsigned long)vt::value.isr_vector[vt::irq_channel_offset + 42] == (unsigned long)isr_42);
+
+#ifdef UNITTEST_MUST_FAIL
+#warning UNITTEST_MUST_FAIL: static_assert failed "irq number is reserved"
+  vt::set_handler< irq_base<-3> >(isr_42_fast);
+#endif
+
   vt::dump_size();
   vt::dump_types();
   vt::dump_vector();